@@ -0,0 +1,46 @@
+#ifndef BITBASE_H
+#define BITBASE_H
+
+#include "types.h"
+
+/* Win/draw/loss for the side to move, two bits per position. */
+#define BB_UNKNOWN 0 /* no table, illegal position, or not resolved */
+#define BB_LOSS 1
+#define BB_DRAW 2
+#define BB_WIN 3
+#define BITBASE_MAX_PIECES 4
+#define BITBASE_TABLES 9
+#define BITBASE_WIN_SCORE 20000
+
+/* An ending as named ("KRKP"): the strong side's pieces from its king, then
+   the weak side's. Tables store it with the strong side as white; a position
+   is indexed as stm, then each piece's square (pawns count ranks 2-7 only). */
+typedef struct {
+  const char *name;
+  int n;
+  int color[BITBASE_MAX_PIECES];
+  int type[BITBASE_MAX_PIECES];
+  U64 size;
+  int plies;
+} BitbaseDef;
+
+/* File layout: this header, then the packed table, four positions a byte. */
+typedef struct {
+  char magic[4];
+  uint16_t id;
+  uint16_t plies; /* longest win in the table, in plies to mate or conversion */
+  uint64_t size;
+} BitbaseHeader;
+
+extern BitbaseDef bitbase_defs[BITBASE_TABLES];
+
+void bitbase_defs_init(void);
+U64 bitbase_index(const BitbaseDef *d, const int *sq, int stm);
+/* Uses wdl (size / 4 bytes rounded up) as table id from now on. */
+void bitbase_attach(int id, const uint8_t *wdl, int plies);
+/* Maps <dir>/<name>.bb for every table; returns how many loaded. */
+int bitbase_load(const char *dir);
+/* BB_* for the side to move; plies, if given, gets the table's longest win. */
+int bitbase_probe(const Board *b, int *plies);
+
+#endif
@@ -3,12 +3,23 @@
 
 #include "types.h"
 
-void board_reset(Board *b);
-void board_from_fen(Board *b, const char *fen);
+void board_reset(Position *pos);
+void board_from_fen(Position *pos, const char *fen);
 void board_sync(Board *b);
-int make_move(Board *b, Move m);
-void unmake_move(Board *b, Move m);
-void board_clear_hist(void);
-int board_is_repetition(const Board *b);
+/* Recomputes psq, phase, non_pawn and mat_key from the bitboards. */
+void board_compute_acc(Board *b);
+/* Returns 0 when the board has more than 32 pieces. */
+int board_pack(const Board *b, PackedBoard *pb);
+void board_unpack(const PackedBoard *pb, Position *pos);
+int board_make(Board *b, Move m, Hist *h);
+void board_unmake(Board *b, Move m, const Hist *h);
+int make_move(Position *pos, Move m);
+void unmake_move(Position *pos, Move m);
+U64 key_after(const Board *b, Move m);
+void board_clear_hist(Position *pos);
+void board_pop_hist(Position *pos);
+/* b is the board at the end of pos's history: pos->b, or the search's copy of it. */
+int board_is_repetition(const Position *pos, const Board *b);
+int board_upcoming_repetition(const Position *pos, const Board *b, int ply);
 
 #endif
@@ -0,0 +1,18 @@
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include "types.h"
+
+#define EG_NONE 0
+#define EG_DRAW 1  /* dead draw: exact, search returns it without expanding the node */
+#define EG_SCALE 2 /* drawish: the eval is multiplied by scale / EG_SCALE_NORMAL */
+#define EG_SCALE_NORMAL 64
+
+/* Fills the recognizer table keyed by Board.mat_key. */
+void endgame_init(void);
+int endgame_probe(const Board *b, int *scale);
+/* Material key of code ("KBNK": the strong side's pieces from its king, then
+   the weak side's) with the strong side playing colour strong. */
+U64 endgame_mat_key(const char *code, int strong);
+
+#endif
@@ -1,12 +1,44 @@
 #ifndef ENGINE_H
 #define ENGINE_H
 
+#include "bitbase.h"
 #include "board.h"
+#include "endgame.h"
+#include "eval.h"
+#include "nnue.h"
+#include "params.h"
 #include "search.h"
 #include "tables.h"
 
-static inline void engine_init(void) {
+#include <stdio.h>
+#include <stdlib.h>
+
+/* slider: backend name from the command line, or NULL to use SLIDER_BACKEND / CPUID. */
+static inline void engine_init(const char *slider) {
+  const char *pf = getenv("PARAMS_FILE");
+  if (pf && *pf) {
+#ifdef TUNABLE
+    int n = params_load(pf);
+    if (n < 0) fprintf(stderr, "params: cannot read %s\n", pf);
+    else fprintf(stderr, "params: %d set from %s\n", n, pf);
+#else
+    fprintf(stderr, "params: %s ignored, parameters are fixed unless built with TUNABLE=1\n", pf);
+#endif
+  }
   init_tables();
+  init_sliders(slider_pick(slider));
+  endgame_init();
+  eval_cache_init();
+  fprintf(stderr, "slider attacks: %s\n", slider_backend_name(slider_backend));
+  const char *bb_dir = getenv("BITBASE_DIR");
+  if (!bb_dir || !*bb_dir) bb_dir = "bitbases";
+  int bb = bitbase_load(bb_dir);
+  if (bb) fprintf(stderr, "bitbases: %d tables from %s\n", bb, bb_dir);
+  const char *net = getenv("EVAL_NNUE");
+  if (net && *net) {
+    if (nnue_init(net, NULL)) fprintf(stderr, "eval: nnue %s (%s)\n", net, nnue_kernel_name());
+    else fprintf(stderr, "eval: classic (cannot load network %s)\n", net);
+  }
 }
 
 #endif
@@ -3,6 +3,21 @@
 
 #include "types.h"
 
+/* Term sets eval() can be compiled for; each adds to the one before. */
+#define EVAL_PROFILE_MATERIAL 0 /* material, PST, tempo */
+#define EVAL_PROFILE_PAWNS 1    /* + pawn hash, bishop pair, rook files */
+#define EVAL_PROFILE_FULL 2     /* + attack maps: mobility, king attack, hanging, centre */
+
 int eval(const Board *b);
+int evaluate(Position *pos, const Board *b);
+/* Classic eval of n positions into out[], spread over EVAL_THREADS threads. */
+void eval_batch(const PackedBoard *in, int n, int *out);
+void attack_info_init(const Board *b, AttackInfo *ai);
+int eval_profile_for_time(int ms);
+void eval_set_profile(int profile);
+const char *eval_profile_name(int profile);
+void eval_cache_init(void);
+void eval_cache_reset_stats(void);
+int eval_cache_hit_pct(void);
 
 #endif
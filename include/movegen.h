@@ -3,10 +3,22 @@
 
 #include "types.h"
 
+#define GEN_ALL 0
+#define GEN_CAPTURES 1 /* captures and promotions */
+#define GEN_QUIETS 2   /* everything else */
+
 int is_attacked(const Board *b, int sq, int side);
 void gen_moves(const Board *b, MoveList *ml);
 void gen_captures(const Board *b, MoveList *ml);
+void gen_legal(const Board *b, MoveList *ml, int type);
+U64 board_checkers(const Board *b);
+U64 board_pinned(const Board *b, int side);
+void check_info_init(const Board *b, CheckInfo *ci);
+int move_gives_check(const Board *b, const CheckInfo *ci, Move m);
 int move_is_legal(Board *b, Move m);
+int move_is_pseudo_legal(const Board *b, Move m);
+int move_is_legal_fast(const Board *b, Move m, U64 checkers, U64 pinned);
 int see(const Board *b, Move m);
+int see_ge(const Board *b, Move m, int threshold);
 
 #endif
@@ -0,0 +1,21 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include "types.h"
+
+#define NNUE_KERNEL_SCALAR 0
+#define NNUE_KERNEL_SSE41 1
+#define NNUE_KERNEL_AVX2 2
+
+/* Maps a network file; kernel is "scalar", "sse41", "avx2" or NULL for CPU
+   detection (NNUE_SIMD overrides). Returns 0 and keeps the classic eval on failure. */
+int nnue_init(const char *path, const char *kernel);
+int nnue_active(void);
+const char *nnue_kernel_name(void);
+/* b is the board at the end of pos's history (see board_is_repetition). */
+int nnue_evaluate(Position *pos, const Board *b);
+int nnue_evaluate_full(const Board *b);
+/* Evaluates pos incrementally; 0 if the accumulator or score differ from a full refresh. */
+int nnue_verify(Position *pos);
+
+#endif
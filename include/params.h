@@ -1,88 +1,117 @@
 #ifndef PARAMS_H
 #define PARAMS_H
 
-extern const int PARAM_QMAX;
-extern const int PARAM_NULL_DEPTH;
-extern const int PARAM_LMR_DEPTH;
-extern const int PARAM_LMR_MOVES;
-extern const int PARAM_ASPIRATION_DELTA;
-extern const int PARAM_ASPIRATION_GROW;
-extern const int PARAM_MATE_WINDOW_MARGIN;
-extern const int PARAM_MATE_SCORE_CUTOFF;
-extern const int PARAM_HASH_MOVE_SCORE;
-extern const int PARAM_HASH_MOVE_TOP_SCORE;
-extern const int PARAM_CHECK_BONUS;
-extern const int PARAM_PROMO_BASE_SCORE;
-extern const int PARAM_PROMO_CAPTURE_BONUS;
-extern const int PARAM_CAPTURE_BASE_SCORE;
-extern const int PARAM_CAPTURE_MVV_LVA_FACTOR;
-extern const int PARAM_SEE_GOOD_BONUS;
-extern const int PARAM_SEE_BAD_PENALTY;
-extern const int PARAM_KILLER_SCORE_1;
-extern const int PARAM_KILLER_SCORE_2;
-extern const int PARAM_HISTORY_MAX;
-extern const int PARAM_TIME_CHECK_INTERVAL;
-extern const int PARAM_NULL_REDUCTION;
-extern const int PARAM_LMR_REDUCTION;
-extern const int PARAM_MATE_SCORE_WINDOW;
-extern const int PARAM_RAZOR_MARGIN;
-extern const int PARAM_FUTILITY_MARGIN;
-extern const int PARAM_LMP_DEPTH;
-extern const int PARAM_LMP_MOVES;
-extern const int PARAM_FIFTY_MOVE_LIMIT;
+/* Every tunable constant as X(name, default). Release builds make them enum
+   constants so uses fold at compile time; TUNABLE=1 builds make them ints
+   that params_set / params_load (PARAMS_FILE) can change at runtime. */
+#define PARAM_LIST_SEARCH(X) \
+  X(PARAM_QMAX, 32) \
+  X(PARAM_NULL_DEPTH, 2) \
+  X(PARAM_LMR_DEPTH, 4) \
+  X(PARAM_LMR_MOVES, 4) \
+  X(PARAM_ASPIRATION_DELTA, 60) \
+  X(PARAM_ASPIRATION_GROW, 30) \
+  X(PARAM_MATE_WINDOW_MARGIN, 500) \
+  X(PARAM_MATE_SCORE_CUTOFF, 64) \
+  X(PARAM_HASH_MOVE_SCORE, 30000) \
+  X(PARAM_HASH_MOVE_TOP_SCORE, 20000) \
+  X(PARAM_CHECK_BONUS, 2000) \
+  X(PARAM_PROMO_BASE_SCORE, 25000) \
+  X(PARAM_PROMO_CAPTURE_BONUS, 8000) \
+  X(PARAM_CAPTURE_BASE_SCORE, 10000) \
+  X(PARAM_CAPTURE_MVV_LVA_FACTOR, 10) \
+  X(PARAM_SEE_GOOD_BONUS, 500) \
+  X(PARAM_SEE_BAD_PENALTY, 1500) \
+  X(PARAM_KILLER_SCORE_1, 9000) \
+  X(PARAM_KILLER_SCORE_2, 8000) \
+  X(PARAM_HISTORY_MAX, 2000000) \
+  X(PARAM_TIME_CHECK_INTERVAL, 1024) \
+  X(PARAM_NULL_REDUCTION, 1) \
+  X(PARAM_LMR_REDUCTION, 2) \
+  X(PARAM_MATE_SCORE_WINDOW, 1000) \
+  X(PARAM_RAZOR_MARGIN, 350) \
+  X(PARAM_FUTILITY_MARGIN, 120) \
+  X(PARAM_LMP_DEPTH, 2) \
+  X(PARAM_LMP_MOVES, 8) \
+  X(PARAM_FIFTY_MOVE_LIMIT, 100)
 
-extern const int PARAM_PHASE_MAX;
-extern const int PARAM_PHASE_PAWN;
-extern const int PARAM_PHASE_KNIGHT;
-extern const int PARAM_PHASE_BISHOP;
-extern const int PARAM_PHASE_ROOK;
-extern const int PARAM_PHASE_QUEEN;
+#define PARAM_LIST_PHASE(X) \
+  X(PARAM_PHASE_MAX, 24) \
+  X(PARAM_PHASE_PAWN, 0) \
+  X(PARAM_PHASE_KNIGHT, 1) \
+  X(PARAM_PHASE_BISHOP, 1) \
+  X(PARAM_PHASE_ROOK, 2) \
+  X(PARAM_PHASE_QUEEN, 4)
 
-extern const int PARAM_VAL_PAWN;
-extern const int PARAM_VAL_KNIGHT;
-extern const int PARAM_VAL_BISHOP;
-extern const int PARAM_VAL_ROOK;
-extern const int PARAM_VAL_QUEEN;
-extern const int PARAM_VAL_KING;
+#define PARAM_LIST_MATERIAL(X) \
+  X(PARAM_VAL_PAWN, 100) \
+  X(PARAM_VAL_KNIGHT, 320) \
+  X(PARAM_VAL_BISHOP, 330) \
+  X(PARAM_VAL_ROOK, 500) \
+  X(PARAM_VAL_QUEEN, 900) \
+  X(PARAM_VAL_KING, 0)
 
-extern const int PARAM_PAWN_DOUBLED_PENALTY;
-extern const int PARAM_PAWN_ISOLATED_PENALTY;
-extern const int PARAM_PASSED_PAWN_BASE;
-extern const int PARAM_PASSED_PAWN_ADVANCE;
-extern const int PARAM_KING_SHIELD_RANK1;
-extern const int PARAM_KING_SHIELD_RANK2;
-extern const int PARAM_KING_OPEN_FILE_PENALTY;
-extern const int PARAM_KING_BACK_RANK_PENALTY;
-extern const int PARAM_ROOK_OPEN_FILE_BONUS;
-extern const int PARAM_ROOK_SEMI_OPEN_BONUS;
-extern const int PARAM_ROOK_SEVENTH_BONUS;
-extern const int PARAM_PAWN_STRUCTURE_WEIGHT;
-extern const int PARAM_KING_SAFETY_WEIGHT;
-extern const int PARAM_ROOK_ACTIVITY_WEIGHT;
-extern const int PARAM_BISHOP_PAIR_BONUS;
-extern const int PARAM_KING_ATTACK_SCALE;
-extern const int PARAM_ATTACK_WEIGHT_PAWN;
-extern const int PARAM_ATTACK_WEIGHT_MINOR;
-extern const int PARAM_ATTACK_WEIGHT_ROOK;
-extern const int PARAM_ATTACK_WEIGHT_QUEEN;
-extern const int PARAM_HANGING_PENALTY_PCT;
-extern const int PARAM_TEMPO_BONUS;
-extern const int PARAM_MOBILITY_WEIGHT;
-extern const int PARAM_CENTER_OCC_BONUS;
-extern const int PARAM_CENTER_EXT_BONUS;
-extern const int PARAM_CONTEMPT;
-extern const int PARAM_TT_HIT_MIN_DEPTH;
-extern const int PARAM_TT_HIT_TIME_MS;
-extern const int PARAM_TT_HIT_TIME_PCT;
-extern const int PARAM_TT_INSTANT_HIT;
-extern const int PARAM_PV_STABLE_DELTA;
-extern const int PARAM_PV_STABLE_MIN_DEPTH;
-extern const int PARAM_DEFAULT_SEARCH_DEPTH;
-extern const int PARAM_DEFAULT_MOVE_TIME_MS;
-extern const int PARAM_MOVE_TIME_INCREMENT_MS;
-extern const int PARAM_TT_CLEAR_ON_NEW_SEARCH;
-extern const int PARAM_TT_LOAD_ON_START;
-extern const int PARAM_TT_SAVE_ON_EXIT;
-extern const char *PARAM_TT_CACHE_PATH;
+#define PARAM_LIST_EVAL(X) \
+  X(PARAM_PAWN_DOUBLED_PENALTY, 24) \
+  X(PARAM_PAWN_ISOLATED_PENALTY, 12) \
+  X(PARAM_PASSED_PAWN_BASE, 20) \
+  X(PARAM_PASSED_PAWN_ADVANCE, 12) \
+  X(PARAM_KING_SHIELD_RANK1, 18) \
+  X(PARAM_KING_SHIELD_RANK2, 10) \
+  X(PARAM_KING_OPEN_FILE_PENALTY, 30) \
+  X(PARAM_KING_BACK_RANK_PENALTY, 12) \
+  X(PARAM_ROOK_OPEN_FILE_BONUS, 22) \
+  X(PARAM_ROOK_SEMI_OPEN_BONUS, 14) \
+  X(PARAM_ROOK_SEVENTH_BONUS, 14) \
+  X(PARAM_PAWN_STRUCTURE_WEIGHT, 1) \
+  X(PARAM_KING_SAFETY_WEIGHT, 3) \
+  X(PARAM_ROOK_ACTIVITY_WEIGHT, 2) \
+  X(PARAM_BISHOP_PAIR_BONUS, 35) \
+  X(PARAM_KING_ATTACK_SCALE, 8) \
+  X(PARAM_ATTACK_WEIGHT_PAWN, 3) \
+  X(PARAM_ATTACK_WEIGHT_MINOR, 4) \
+  X(PARAM_ATTACK_WEIGHT_ROOK, 6) \
+  X(PARAM_ATTACK_WEIGHT_QUEEN, 8) \
+  X(PARAM_HANGING_PENALTY_PCT, 80) \
+  X(PARAM_TEMPO_BONUS, 15) \
+  X(PARAM_MOBILITY_WEIGHT, 7) \
+  X(PARAM_CENTER_OCC_BONUS, 12) \
+  X(PARAM_CENTER_EXT_BONUS, 6)
+
+#define PARAM_LIST_ENGINE(X) \
+  X(PARAM_CONTEMPT, 20) \
+  X(PARAM_TT_HIT_MIN_DEPTH, 2) \
+  X(PARAM_TT_HIT_TIME_MS, 1500) \
+  X(PARAM_TT_HIT_TIME_PCT, 40) \
+  X(PARAM_TT_INSTANT_HIT, 1) \
+  X(PARAM_PV_STABLE_DELTA, 20) \
+  X(PARAM_PV_STABLE_MIN_DEPTH, 3) \
+  X(PARAM_DEFAULT_SEARCH_DEPTH, 52) \
+  X(PARAM_DEFAULT_MOVE_TIME_MS, 10000) \
+  X(PARAM_MOVE_TIME_INCREMENT_MS, 0) \
+  X(PARAM_TT_CLEAR_ON_NEW_SEARCH, 0) \
+  X(PARAM_TT_LOAD_ON_START, 1) \
+  X(PARAM_TT_SAVE_ON_EXIT, 1) \
+  X(PARAM_EVAL_MATERIAL_MS, 30) \
+  X(PARAM_EVAL_PAWNS_MS, 100)
+
+#define PARAM_LIST(X) PARAM_LIST_SEARCH(X) PARAM_LIST_PHASE(X) PARAM_LIST_MATERIAL(X) PARAM_LIST_EVAL(X) PARAM_LIST_ENGINE(X)
+
+#ifdef TUNABLE
+#define PARAM_DECLARE(name, v) extern int name;
+PARAM_LIST(PARAM_DECLARE)
+#undef PARAM_DECLARE
+#else
+#define PARAM_ENUM(name, v) name = (v),
+enum { PARAM_LIST(PARAM_ENUM) };
+#undef PARAM_ENUM
+#endif
+
+#define PARAM_TT_CACHE_PATH "tt_cache.bin"
+
+/* Set one parameter by name; returns 0 for an unknown name or in a release build. */
+int params_set(const char *name, int value);
+/* Reads "NAME value" lines; returns the number applied, or -1 if the file cannot be read. */
+int params_load(const char *path);
 
 #endif
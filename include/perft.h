@@ -0,0 +1,11 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include "types.h"
+
+U64 perft(Position *pos, int depth);
+/* Counts leaf nodes to depth, printing one line per root move when divide is set.
+   PERFT_THREADS splits the root moves across threads, PERFT_HASH_MB enables the hash. */
+U64 perft_run(const Position *pos, int depth, int divide);
+
+#endif
@@ -3,25 +3,100 @@
 
 #include "types.h"
 
-extern U64 knight_att[64];
-extern U64 king_att[64];
-extern U64 pawn_push[2][64];
-extern U64 pawn_att[2][64];
-extern U64 inv_pawn_att[2][64];
-extern U64 ray_att[64][8];
-extern int ray_dir[64][64];
-extern int pst[2][6][64];
+typedef struct {
+  U64 mask;
+  U64 magic;
+  int offset;
+  int shift;
+} Magic;
+
+#define SLIDER_PORTABLE 0
+#define SLIDER_MAGIC 1
+#define SLIDER_PEXT 2
+#define SLIDER_TABLE_SIZE (5248 + 102400)
+
+/* The const tables are generated at build time into src/tables_gen.c by tools/gen_tables.c. */
+extern const U64 knight_att[64];
+extern const U64 king_att[64];
+extern const U64 pawn_push[2][64];
+extern const U64 pawn_att[2][64];
+extern const U64 inv_pawn_att[2][64];
+extern const U64 ray_att[64][8];
+extern const int ray_dir[64][64];
+extern const U64 between_bb[64][64];
+extern const U64 line_bb[64][64];
+extern const Magic bishop_magic[64];
+extern const Magic rook_magic[64];
+extern const U64 slider_att[SLIDER_TABLE_SIZE];
+extern const U64 slider_att_pext[SLIDER_TABLE_SIZE];
+extern const U64 cuckoo_key[CUCKOO_SIZE];
+extern const Move cuckoo_move[CUCKOO_SIZE];
+extern int slider_backend;
+extern const Score pst[2][6][64];
+extern const U64 isolated_mask[8];
+extern const U64 passed_mask[2][64];
 extern int piece_val[6];
+extern Score piece_score[6];
+extern int piece_phase[6];
 extern HashEntry tt[HASH_SIZE];
+extern PawnEntry pawn_tt[PAWN_HASH_SIZE];
+extern const U64 zobrist_piece[2][6][64];
+extern const U64 zobrist_side;
+extern const U64 zobrist_ep[8];
+extern const U64 zobrist_castle[4];
+extern const U64 zobrist_castle_set[16];
 int tt_was_loaded(void);
 
 void init_tables(void);
+void init_sliders(int backend);
+int slider_pick(const char *override);
+const char *slider_backend_name(int backend);
+U64 slider_attacks_portable(int sq, U64 occ, int rook);
 U64 tables_compute_key(const Board *b);
+U64 tables_compute_pawn_key(const Board *b);
 U64 tables_key_after_null(const Board *b);
-void tables_ensure_zobrist(void);
-int tables_zobrist_ready(void);
 void tt_clear(void);
 int tt_load(const char *path);
 int tt_save(const char *path);
 
+static inline void tt_prefetch(U64 key) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(&tt[key & HASH_MASK]);
+#else
+  (void)key;
+#endif
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HAVE_PEXT 1
+/* Inline asm rather than _pext_u64, which would need every caller built for
+   BMI2; slider_pick only selects SLIDER_PEXT on CPUs that have it. */
+static inline U64 pext_u64(U64 x, U64 mask) {
+  U64 r;
+  __asm__("pextq %2, %1, %0" : "=r"(r) : "r"(x), "rm"(mask));
+  return r;
+}
+#endif
+
+/* slider_backend is fixed by init_sliders, so the branch always predicts. */
+static inline U64 slider_lookup(const Magic *m, int sq, U64 occ, int rook) {
+#ifdef HAVE_PEXT
+  if (slider_backend == SLIDER_PEXT) return slider_att_pext[m->offset + pext_u64(occ, m->mask)];
+#endif
+  if (slider_backend == SLIDER_MAGIC) return slider_att[m->offset + (((occ & m->mask) * m->magic) >> m->shift)];
+  return slider_attacks_portable(sq, occ, rook);
+}
+
+static inline U64 bishop_attacks(int sq, U64 occ) {
+  return slider_lookup(&bishop_magic[sq], sq, occ, 0);
+}
+
+static inline U64 rook_attacks(int sq, U64 occ) {
+  return slider_lookup(&rook_magic[sq], sq, occ, 1);
+}
+
+static inline U64 queen_attacks(int sq, U64 occ) {
+  return bishop_attacks(sq, occ) | rook_attacks(sq, occ);
+}
+
 #endif
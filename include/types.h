@@ -18,29 +18,127 @@
 #define MAX_DEPTH 64
 #define HASH_SIZE 524288
 #define HASH_MASK (HASH_SIZE - 1)
+#define PAWN_HASH_SIZE 16384
+#define PAWN_HASH_MASK (PAWN_HASH_SIZE - 1)
 #define HIST_SIZE 1024
+#define NNUE_HALF 256
+#define NNUE_ACC_PLIES 128
+#define CUCKOO_SIZE 8192
+#define CUCKOO_H1(k) ((int)((k) & 0x1FFF))
+#define CUCKOO_H2(k) ((int)(((k) >> 16) & 0x1FFF))
 
 typedef uint64_t U64;
 typedef uint16_t Move;
 
+/* Packed midgame/endgame pair: eg in the high 16 bits, mg in the low 16, so
+   one add, subtract or multiply by a small int updates both phases. */
+typedef int32_t Score;
+#define S(mg, eg) ((Score)((uint32_t)(eg) << 16) + (Score)(mg))
+#define MG_OF(s) ((int16_t)(uint16_t)(uint32_t)(s))
+#define EG_OF(s) ((int16_t)(uint16_t)((uint32_t)((s) + 0x8000) >> 16))
+
+#define NO_PIECE 12
+#define MAKE_PIECE(c,p) ((c)*6+(p))
+
+static const uint8_t piece_type_of[13] = { P, N, BISHOP, R, Q, K, P, N, BISHOP, R, Q, K, N_PIECES };
+static const uint8_t piece_color_of[13] = { W, W, W, W, W, W, B, B, B, B, B, B, 2 };
+
+#define PTYPE(pc) (piece_type_of[pc])
+#define PCOLOR(pc) (piece_color_of[pc])
+
+/* Bitboards, key and the small state fields fill the first 128 bytes (two
+   cache lines); the byte mailbox takes a third. */
 typedef struct {
   U64 p[2][6];
   U64 occ[2];
-  int side;
-  int castle;
-  int ep;
-  int fifty;
-  int ply;
   U64 key;
-  int piece_on[64];
-  int king_sq[2];
+  uint8_t side;
+  uint8_t castle;
+  int8_t ep;
+  int8_t king_sq[2];
+  uint8_t pad;
+  uint16_t fifty;
+  uint8_t piece_on[64];
+  int ply;
+  uint16_t since_null; /* plies since the last null move, bounds repetition scans */
+  U64 pawn_key;
+  Score psq;           /* material + PST, white's view */
+  int16_t phase;       /* unclamped game phase from piece_phase[] */
+  int16_t non_pawn[2]; /* non-pawn material per side */
+  U64 mat_key;         /* piece counts, 4 bits per MAKE_PIECE code */
 } Board;
 
+#define MAT_KEY_UNIT(pc) (1ULL << (4 * (pc)))
+
+/* State to undo a move, plus the move and moving piece for incremental eval. */
+typedef struct {
+  U64 key;
+  uint16_t fifty;
+  uint16_t since_null;
+  uint8_t castle;
+  int8_t ep;
+  uint8_t cap;
+  uint8_t piece;
+  Move move;
+} Hist;
+
+/* NNUE feature-transformer output for both perspectives. */
+typedef struct {
+  _Alignas(32) int16_t v[2][NNUE_HALF];
+} Accumulator;
+
+/* A board plus its own undo stack; repetition checks only look at this history.
+   acc is a ring of NNUE accumulators indexed by hply % NNUE_ACC_PLIES; a slot
+   is valid while acc_key holds the key of the position it was computed for.
+   COPY_MAKE builds search on copy[hply], the board after hist[hply - 1]. */
+typedef struct {
+  Board b;
+  Hist hist[HIST_SIZE];
+  int hply;
+  U64 acc_key[NNUE_ACC_PLIES];
+  Accumulator acc[NNUE_ACC_PLIES];
+#ifdef COPY_MAKE
+  Board copy[HIST_SIZE + 1];
+#endif
+} Position;
+
+/* 32-byte position for batch eval: the occupancy plus one 4-bit MAKE_PIECE
+   code per occupied square in square order, low nibble first. */
+typedef struct {
+  U64 occ;
+  uint8_t pieces[16];
+  uint8_t side;
+  uint8_t castle;
+  int8_t ep;
+  uint8_t fifty;
+} PackedBoard;
+
 typedef struct {
   Move m[MAX_MOVES];
   int n;
 } MoveList;
 
+/* Per-node check data for the side to move: squares from which each piece
+   type would attack the enemy king, and our pieces whose move may uncover a
+   check from one of our sliders. */
+typedef struct {
+  U64 check_sq[6];
+  U64 discovered;
+  int ksq;
+} CheckInfo;
+
+/* Attack maps built once per eval: squares attacked by each side and piece
+   type, squares attacked at least twice, and each king's zone. mobility and
+   zone_weight are tallied per piece while the maps are built. */
+typedef struct {
+  U64 by_type[2][6];
+  U64 all[2];
+  U64 twice[2];
+  U64 king_zone[2];
+  int mobility[2];
+  int zone_weight[2];
+} AttackInfo;
+
 typedef struct {
   U64 key;
   int depth;
@@ -51,6 +149,16 @@ typedef struct {
   uint8_t pad[3];
 } HashEntry;
 
+/* Pawn hash entry: weighted pawn-structure score (white's view), passed pawns,
+   and the king-shelter terms, which are only valid while the kings stay on ksq[]. */
+typedef struct {
+  U64 key;
+  U64 passed[2];
+  Score score;
+  Score shelter[2];
+  int8_t ksq[2];
+} PawnEntry;
+
 #define SQ(f,r) ((r)*8+(f))
 #define FILE(s) ((s)&7)
 #define RANK(s) ((s)>>3)
@@ -71,10 +179,17 @@ static inline int bit_ctz64(U64 x) {
   unsigned long i;
   return _BitScanForward64(&i, x) ? (int)i : 64;
 }
+static inline int bit_msb64(U64 x) {
+  unsigned long i;
+  return _BitScanReverse64(&i, x) ? (int)i : -1;
+}
 #else
 static inline int bit_ctz64(U64 x) {
   return x ? (int)__builtin_ctzll(x) : 64;
 }
+static inline int bit_msb64(U64 x) {
+  return x ? 63 - (int)__builtin_clzll(x) : -1;
+}
 #endif
 
 #define POP(b) bit_ctz64(b)
@@ -0,0 +1,123 @@
+#include "bitbase.h"
+#include "endgame.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define BITBASE_NO_MMAP 1
+#include <stdlib.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* Generation order: every capture or promotion leads to an earlier table or
+   to a recognized draw. KRKR, KRKB and KRKN are there for KRKP's
+   underpromotions. */
+static const char *bitbase_names[BITBASE_TABLES] = { "KQK", "KRK", "KPK", "KQKR", "KBNK", "KRKR", "KRKB", "KRKN", "KRKP" };
+
+BitbaseDef bitbase_defs[BITBASE_TABLES];
+static U64 bitbase_keys[BITBASE_TABLES][2];
+static const uint8_t *bitbase_data[BITBASE_TABLES];
+static int bitbase_count;
+
+void bitbase_defs_init(void) {
+  static const char letters[] = "PNBRQK";
+  for (int id = 0; id < BITBASE_TABLES; id++) {
+    BitbaseDef *d = &bitbase_defs[id];
+    const char *name = bitbase_names[id];
+    d->name = name;
+    d->n = 0;
+    d->size = 2;
+    for (int i = 0, color = -1; name[i] && d->n < BITBASE_MAX_PIECES; i++) {
+      int type = (int)(strchr(letters, name[i]) - letters);
+      if (type == K) color++;
+      d->color[d->n] = color;
+      d->type[d->n++] = type;
+      d->size *= type == P ? 48 : 64;
+    }
+    bitbase_keys[id][W] = endgame_mat_key(name, W);
+    bitbase_keys[id][B] = endgame_mat_key(name, B);
+  }
+}
+
+U64 bitbase_index(const BitbaseDef *d, const int *sq, int stm) {
+  U64 i = (U64)stm;
+  for (int k = 0; k < d->n; k++) i = d->type[k] == P ? i * 48 + (U64)(sq[k] - 8) : i * 64 + (U64)sq[k];
+  return i;
+}
+
+void bitbase_attach(int id, const uint8_t *wdl, int plies) {
+  if (!bitbase_defs[0].name) bitbase_defs_init();
+  if (wdl && !bitbase_data[id]) bitbase_count++;
+  bitbase_data[id] = wdl;
+  bitbase_defs[id].plies = plies;
+}
+
+static const uint8_t *map_table(const char *path, U64 entries, int *plies) {
+  size_t len = sizeof(BitbaseHeader) + (size_t)((entries + 3) / 4);
+  BitbaseHeader h;
+#ifdef BITBASE_NO_MMAP
+  FILE *f = fopen(path, "rb");
+  if (!f) return NULL;
+  uint8_t *p = malloc(len);
+  if (p && fread(p, 1, len, f) != len) { free(p); p = NULL; }
+  fclose(f);
+  if (!p) return NULL;
+  memcpy(&h, p, sizeof h);
+  if (memcmp(h.magic, "BBv2", 4) != 0 || h.size != entries) { free(p); return NULL; }
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return NULL;
+  struct stat st;
+  void *m = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && (size_t)st.st_size == len) m = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (m == MAP_FAILED) return NULL;
+  const uint8_t *p = m;
+  memcpy(&h, p, sizeof h);
+  if (memcmp(h.magic, "BBv2", 4) != 0 || h.size != entries) { munmap(m, len); return NULL; }
+#endif
+  *plies = h.plies;
+  return p + sizeof h;
+}
+
+int bitbase_load(const char *dir) {
+  bitbase_defs_init();
+  for (int id = 0; id < BITBASE_TABLES; id++) {
+    char path[512];
+    snprintf(path, sizeof path, "%s/%s.bb", dir, bitbase_defs[id].name);
+    int plies = 0;
+    const uint8_t *wdl = map_table(path, bitbase_defs[id].size, &plies);
+    if (wdl) bitbase_attach(id, wdl, plies);
+  }
+  return bitbase_count;
+}
+
+int bitbase_probe(const Board *b, int *plies) {
+  U64 occ = b->occ[W] | b->occ[B];
+  for (int i = 0; i < BITBASE_MAX_PIECES && occ; i++) occ &= occ - 1;
+  if (occ || !bitbase_count) return BB_UNKNOWN;
+  for (int id = 0; id < BITBASE_TABLES; id++) {
+    for (int strong = W; strong <= B; strong++) {
+      if (b->mat_key != bitbase_keys[id][strong] || !bitbase_data[id]) continue;
+      const BitbaseDef *d = &bitbase_defs[id];
+      U64 seen[2][6] = { { 0 } };
+      int sq[BITBASE_MAX_PIECES];
+      for (int k = 0; k < d->n; k++) {
+        int c = d->color[k] ^ strong, t = d->type[k];
+        U64 bb = b->p[c][t] & ~seen[c][t];
+        int s = POP(bb);
+        seen[c][t] |= 1ULL << s;
+        sq[k] = strong == W ? s : s ^ 56;
+      }
+      U64 i = bitbase_index(d, sq, b->side ^ strong);
+      if (plies) *plies = d->plies;
+      return (bitbase_data[id][i >> 2] >> ((i & 3) * 2)) & 3;
+    }
+  }
+  return BB_UNKNOWN;
+}
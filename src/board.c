@@ -5,23 +5,72 @@
 #include <stdlib.h>
 #include <string.h>
 
-typedef struct { int castle; int ep; int cap; int fifty; U64 key; } Hist;
-static Hist hist[HIST_SIZE];
-static int hply;
+void board_clear_hist(Position *pos) {
+  pos->hply = 0;
+  memset(pos->acc_key, 0, sizeof pos->acc_key);
+}
+void board_pop_hist(Position *pos) { if (pos->hply > 0) pos->hply--; }
 
-void board_clear_hist(void) { hply = 0; }
-int board_hist_ply(void) { return hply; }
+/* Plies back that a repetition scan may look: not past an irreversible move,
+   a null move, or the start of the history. */
+static inline int rep_window(const Position *pos, const Board *b) {
+  int end = b->fifty < b->since_null ? b->fifty : b->since_null;
+  return end < pos->hply ? end : pos->hply;
+}
 
-int board_is_repetition(const Board *b) {
-  if (hply < 2) return 0;
-  int limit = hply - b->fifty - 1;
-  if (limit < 0) limit = 0;
-  for (int i = hply - 2; i >= limit; i -= 2) {
-    if (hist[i].key == b->key) return 1;
+int board_is_repetition(const Position *pos, const Board *b) {
+  int end = rep_window(pos, b);
+  if (end < 4) return 0;
+  for (int i = 4; i <= end; i += 2) {
+    if (pos->hist[pos->hply - i].key == b->key) return 1;
+  }
+  return 0;
+}
+
+/* True if the side to move has a reversible move reaching a position seen
+   within the last `ply` history entries (i.e. inside the search tree), found
+   through the cuckoo table of single-move key differences. */
+int board_upcoming_repetition(const Position *pos, const Board *b, int ply) {
+  int end = rep_window(pos, b);
+  if (end < 3) return 0;
+  if (end >= ply) end = ply - 1;
+  U64 occ = b->occ[W] | b->occ[B];
+  for (int i = 3; i <= end; i += 2) {
+    U64 diff = b->key ^ pos->hist[pos->hply - i].key;
+    int j = CUCKOO_H1(diff);
+    if (cuckoo_key[j] != diff) {
+      j = CUCKOO_H2(diff);
+      if (cuckoo_key[j] != diff) continue;
+    }
+    Move m = cuckoo_move[j];
+    int s1 = FROM(m), s2 = TO(m);
+    if (between_bb[s1][s2] & occ) continue;
+    int pc = b->piece_on[s1] != NO_PIECE ? b->piece_on[s1] : b->piece_on[s2];
+    if (PCOLOR(pc) == b->side) return 1;
   }
   return 0;
 }
 
+/* Adds (sign 1) or removes (sign -1) a piece from the eval accumulators. */
+static inline void acc_piece(Board *b, int c, int p, int sq, int sign) {
+  Score v = piece_score[p] + pst[c][p][sq];
+  b->psq += c == W ? v * sign : -v * sign;
+  b->phase += piece_phase[p] * sign;
+  b->mat_key += (U64)(int64_t)sign * MAT_KEY_UNIT(MAKE_PIECE(c, p));
+  if (p != P && p != K) b->non_pawn[c] += piece_val[p] * sign;
+}
+
+void board_compute_acc(Board *b) {
+  b->psq = b->phase = 0;
+  b->mat_key = 0;
+  b->non_pawn[W] = b->non_pawn[B] = 0;
+  for (int c = 0; c < 2; c++)
+    for (int p = 0; p < 6; p++) {
+      U64 bb = b->p[c][p];
+      while (bb) { int sq = POP(bb); bb &= bb - 1; acc_piece(b, c, p, sq, 1); }
+    }
+}
+
 void board_sync(Board *b) {
   int c, p, sq;
   b->king_sq[W] = -1;
@@ -29,7 +78,7 @@ void board_sync(Board *b) {
   b->occ[W] = b->p[W][P] | b->p[W][N] | b->p[W][BISHOP] | b->p[W][R] | b->p[W][Q] | b->p[W][K];
   b->occ[B] = b->p[B][P] | b->p[B][N] | b->p[B][BISHOP] | b->p[B][R] | b->p[B][Q] | b->p[B][K];
   for (sq = 0; sq < 64; sq++) {
-    b->piece_on[sq] = -1;
+    b->piece_on[sq] = NO_PIECE;
   }
   for (c = 0; c < 2; c++) {
     for (p = 0; p < 6; p++) {
@@ -37,21 +86,86 @@ void board_sync(Board *b) {
       while (bb) {
         sq = POP(bb);
         bb &= bb - 1;
-        b->piece_on[sq] = c * 6 + p;
+        b->piece_on[sq] = MAKE_PIECE(c, p);
         if (p == K) {
           b->king_sq[c] = sq;
         }
       }
     }
   }
+  b->pawn_key = tables_compute_pawn_key(b);
+  board_compute_acc(b);
 }
 
 static U64 compute_key(const Board *b) {
   return tables_compute_key(b);
 }
 
-void board_reset(Board *b) {
-  board_clear_hist();
+/* Pawn-key change made by a move; applying it again undoes the move. */
+static inline U64 pawn_key_delta(int stm, int pc, int cap, int from, int to, int fl) {
+  U64 d = 0;
+  if (pc == P) {
+    d ^= zobrist_piece[stm][P][from];
+    if (fl != M_PROMO) d ^= zobrist_piece[stm][P][to];
+    if (fl == M_EP) d ^= zobrist_piece[stm ^ 1][P][stm == W ? to - 8 : to + 8];
+  }
+  if (PTYPE(cap) == P) d ^= zobrist_piece[PCOLOR(cap)][P][to];
+  return d;
+}
+
+static inline int promo_type(Move m) {
+  int pr = PROMO_PC(m);
+  if (pr == 0) return N;
+  if (pr == 1) return BISHOP;
+  if (pr == 2) return R;
+  return Q;
+}
+
+static int castle_after(const Board *b, int from, int to) {
+  int castle = b->castle;
+  int cap = b->piece_on[to];
+  if (PTYPE(cap) == R) {
+    if (to == 0) castle &= ~2;
+    if (to == 7) castle &= ~1;
+    if (to == 56) castle &= ~8;
+    if (to == 63) castle &= ~4;
+  }
+  if (from == 4) castle &= ~3;
+  if (from == 60) castle &= ~12;
+  if (from == 0) castle &= ~2;
+  if (from == 7) castle &= ~1;
+  if (from == 56) castle &= ~8;
+  if (from == 63) castle &= ~4;
+  return castle;
+}
+
+U64 key_after(const Board *b, Move m) {
+  int from = FROM(m), to = TO(m), fl = FLAGS(m);
+  int stm = b->side;
+  int piece = b->piece_on[from];
+  U64 k = b->key ^ zobrist_side;
+  if (piece == NO_PIECE) return k;
+  int pc = PTYPE(piece);
+  int cap = b->piece_on[to];
+  if (b->ep >= 0 && b->ep < 64) k ^= zobrist_ep[FILE(b->ep)];
+  k ^= zobrist_piece[stm][pc][from];
+  k ^= zobrist_piece[stm][fl == M_PROMO ? promo_type(m) : pc][to];
+  if (cap != NO_PIECE) k ^= zobrist_piece[PCOLOR(cap)][PTYPE(cap)][to];
+  if (fl == M_EP) k ^= zobrist_piece[stm ^ 1][P][stm == W ? to - 8 : to + 8];
+  if (fl == M_CASTLE) {
+    int rfrom = (to == 6 || to == 62) ? (to + 1) : (to - 2);
+    int rto = (to == 6 || to == 62) ? (to - 1) : (to + 1);
+    k ^= zobrist_piece[stm][R][rfrom] ^ zobrist_piece[stm][R][rto];
+  }
+  if (pc == P && (RANK(to) - RANK(from)) * (stm ? -1 : 1) == 2)
+    k ^= zobrist_ep[FILE(from)];
+  k ^= zobrist_castle_set[b->castle] ^ zobrist_castle_set[castle_after(b, from, to)];
+  return k;
+}
+
+void board_reset(Position *pos) {
+  Board *b = &pos->b;
+  board_clear_hist(pos);
   memset(b, 0, sizeof(Board));
   b->p[W][P] = 0xFF00ULL;
   b->p[W][N] = 0x42ULL;
@@ -72,27 +186,27 @@ void board_reset(Board *b) {
   b->ep = -1;
   b->king_sq[W] = 4;
   b->king_sq[B] = 60;
-  for (int sq = 0; sq < 64; sq++) {
-    b->piece_on[sq] = -1;
-  }
+  memset(b->piece_on, NO_PIECE, sizeof(b->piece_on));
   for (int c = 0; c < 2; c++) {
     for (int p = 0; p < 6; p++) {
       U64 bb = b->p[c][p];
       while (bb) {
         int s = POP(bb);
         bb &= bb - 1;
-        b->piece_on[s] = c * 6 + p;
+        b->piece_on[s] = MAKE_PIECE(c, p);
       }
     }
   }
-  tables_ensure_zobrist();
   b->key = compute_key(b);
+  b->pawn_key = tables_compute_pawn_key(b);
+  board_compute_acc(b);
 }
 
-void board_from_fen(Board *b, const char *fen) {
-  board_clear_hist();
+void board_from_fen(Position *pos, const char *fen) {
+  Board *b = &pos->b;
+  board_clear_hist(pos);
   memset(b, 0, sizeof(Board));
-  for (int i = 0; i < 64; i++) b->piece_on[i] = -1;
+  memset(b->piece_on, NO_PIECE, sizeof(b->piece_on));
   b->king_sq[W] = -1;
   b->king_sq[B] = -1;
   int sq = 56;
@@ -121,7 +235,7 @@ void board_from_fen(Board *b, const char *fen) {
     if (p >= 0) {
       if (sq >= 0 && sq < 64) {
         b->p[c][p] |= 1ULL << sq;
-        b->piece_on[sq] = c * 6 + p;
+        b->piece_on[sq] = MAKE_PIECE(c, p);
         if (p == K) b->king_sq[c] = sq;
       }
       sq++;
@@ -151,47 +265,88 @@ void board_from_fen(Board *b, const char *fen) {
   while (*s == ' ') s++;
   b->fifty = 0;
   if (*s >= '0' && *s <= '9') { b->fifty = atoi(s); while (*s >= '0' && *s <= '9') s++; }
-  tables_ensure_zobrist();
+  b->key = compute_key(b);
+  b->pawn_key = tables_compute_pawn_key(b);
+  board_compute_acc(b);
+}
+
+int board_pack(const Board *b, PackedBoard *pb) {
+  U64 occ = b->occ[W] | b->occ[B];
+  int k = 0;
+  memset(pb, 0, sizeof(*pb));
+  pb->occ = occ;
+  while (occ) {
+    if (k == 32) return 0;
+    int sq = POP(occ);
+    occ &= occ - 1;
+    pb->pieces[k >> 1] |= (uint8_t)(b->piece_on[sq] << ((k & 1) * 4));
+    k++;
+  }
+  pb->side = b->side;
+  pb->castle = b->castle;
+  pb->ep = b->ep;
+  pb->fifty = b->fifty > 255 ? 255 : (uint8_t)b->fifty;
+  return 1;
+}
+
+void board_unpack(const PackedBoard *pb, Position *pos) {
+  Board *b = &pos->b;
+  U64 occ = pb->occ;
+  int k = 0;
+  board_clear_hist(pos);
+  memset(b, 0, sizeof(Board));
+  while (occ) {
+    int sq = POP(occ);
+    occ &= occ - 1;
+    int pc = (pb->pieces[k >> 1] >> ((k & 1) * 4)) & 15;
+    k++;
+    if (pc < NO_PIECE) b->p[PCOLOR(pc)][PTYPE(pc)] |= 1ULL << sq;
+  }
+  b->side = pb->side;
+  b->castle = pb->castle;
+  b->ep = pb->ep;
+  b->fifty = pb->fifty;
+  board_sync(b);
   b->key = compute_key(b);
 }
 
-int make_move(Board *b, Move m) {
+int board_make(Board *b, Move m, Hist *h) {
   int from = FROM(m), to = TO(m), fl = FLAGS(m);
   int stm = b->side;
   int piece = b->piece_on[from];
-  if (piece < 0) {
+  if (piece == NO_PIECE) {
     return 0;
   }
-  if (hply >= HIST_SIZE) return 0;
-  int pc = piece % 6;
-  hist[hply].castle = b->castle;
-  hist[hply].ep = b->ep;
-  hist[hply].cap = b->piece_on[to];
-  hist[hply].fifty = b->fifty;
-  hist[hply].key = b->key;
-  hply++;
+  int pc = PTYPE(piece);
+  U64 key = key_after(b, m);
+  int castle = castle_after(b, from, to);
+  h->castle = b->castle;
+  h->ep = b->ep;
+  h->cap = b->piece_on[to];
+  h->piece = piece;
+  h->move = m;
+  h->fifty = b->fifty;
+  h->since_null = b->since_null;
+  h->key = b->key;
   U64 from_bb = 1ULL << from, to_bb = 1ULL << to;
   b->p[stm][pc] ^= from_bb;
   b->occ[stm] ^= from_bb;
-  b->piece_on[from] = -1;
+  b->piece_on[from] = NO_PIECE;
+  acc_piece(b, stm, pc, from, -1);
   int cap = b->piece_on[to];
-  if (cap >= 0) {
-    int c = cap / 6, p = cap % 6;
+  if (cap != NO_PIECE) {
+    int c = PCOLOR(cap), p = PTYPE(cap);
     b->p[c][p] ^= to_bb;
     b->occ[c] ^= to_bb;
-    if (p == R) {
-      if (to == 0) b->castle &= ~2;
-      if (to == 7) b->castle &= ~1;
-      if (to == 56) b->castle &= ~8;
-      if (to == 63) b->castle &= ~4;
-    }
+    acc_piece(b, c, p, to, -1);
   }
   b->piece_on[to] = piece;
   if (pc == P && fl == M_EP) {
     int epsq = stm == W ? to - 8 : to + 8;
     b->p[stm^1][P] ^= (1ULL << epsq);
     b->occ[stm^1] ^= (1ULL << epsq);
-    b->piece_on[epsq] = -1;
+    b->piece_on[epsq] = NO_PIECE;
+    acc_piece(b, stm ^ 1, P, epsq, -1);
   }
   if (pc == K) {
     b->king_sq[stm] = to;
@@ -200,18 +355,20 @@ int make_move(Board *b, Move m) {
       int rto = (to == 6 || to == 62) ? (to - 1) : (to + 1);
       b->p[stm][R] ^= (1ULL << rfrom) | (1ULL << rto);
       b->occ[stm] ^= (1ULL << rfrom) | (1ULL << rto);
-      b->piece_on[rfrom] = -1;
-      b->piece_on[rto] = stm * 6 + R;
+      b->piece_on[rfrom] = NO_PIECE;
+      b->piece_on[rto] = MAKE_PIECE(stm, R);
+      acc_piece(b, stm, R, rfrom, -1);
+      acc_piece(b, stm, R, rto, 1);
     }
   }
   if (fl == M_PROMO) {
-    int pr = PROMO_PC(m);
-    if (pr == 0) pr = N; else if (pr == 1) pr = BISHOP; else if (pr == 2) pr = R; else pr = Q;
-    b->p[stm][P] ^= to_bb;
+    int pr = promo_type(m);
     b->p[stm][pr] |= to_bb;
-    b->piece_on[to] = stm * 6 + pr;
+    b->piece_on[to] = MAKE_PIECE(stm, pr);
+    acc_piece(b, stm, pr, to, 1);
   } else {
     b->p[stm][pc] |= to_bb;
+    acc_piece(b, stm, pc, to, 1);
   }
   b->occ[stm] |= to_bb;
   b->ep = -1;
@@ -219,35 +376,33 @@ int make_move(Board *b, Move m) {
     b->ep = stm == W ? from + 8 : from - 8;
   }
   b->fifty++;
-  if (pc == P || cap >= 0 || fl == M_EP) b->fifty = 0;
-  if (from == 4) b->castle &= ~3;
-  if (from == 60) b->castle &= ~12;
-  if (from == 0) b->castle &= ~2;
-  if (from == 7) b->castle &= ~1;
-  if (from == 56) b->castle &= ~8;
-  if (from == 63) b->castle &= ~4;
+  b->since_null++;
+  if (pc == P || cap != NO_PIECE || fl == M_EP) b->fifty = 0;
+  b->castle = castle;
   b->side ^= 1;
   b->ply++;
-  b->key = compute_key(b);
+  b->key = key;
+  b->pawn_key ^= pawn_key_delta(stm, pc, h->cap, from, to, fl);
   return 1;
 }
 
-void unmake_move(Board *b, Move m) {
-  hply--;
+void board_unmake(Board *b, Move m, const Hist *h) {
   b->side ^= 1;
   b->ply--;
   int from = FROM(m), to = TO(m), fl = FLAGS(m);
   int stm = b->side;
   int piece = b->piece_on[to];
-  if (piece < 0) {
+  if (piece == NO_PIECE) {
     return;
   }
-  int pc = piece % 6;
+  int pc = PTYPE(piece);
   if (fl == M_PROMO) {
     int pr = PROMO_PC(m);
     if (pr == 0) pr = N; else if (pr == 1) pr = BISHOP; else if (pr == 2) pr = R; else pr = Q;
     b->p[stm][pr] ^= (1ULL << to);
     b->p[stm][P] |= (1ULL << to);
+    acc_piece(b, stm, pr, to, -1);
+    acc_piece(b, stm, P, to, 1);
     pc = P;
   }
   U64 from_bb = 1ULL << from, to_bb = 1ULL << to;
@@ -255,31 +410,51 @@ void unmake_move(Board *b, Move m) {
   b->p[stm][pc] |= from_bb;
   b->occ[stm] ^= to_bb;
   b->occ[stm] |= from_bb;
-  b->piece_on[to] = -1;
-  b->piece_on[from] = stm * 6 + pc;
+  b->piece_on[to] = NO_PIECE;
+  b->piece_on[from] = MAKE_PIECE(stm, pc);
+  acc_piece(b, stm, pc, to, -1);
+  acc_piece(b, stm, pc, from, 1);
   if (pc == K) b->king_sq[stm] = from;
   if (fl == M_CASTLE && pc == K) {
     int rfrom = (to == 6 || to == 62) ? (to + 1) : (to - 2);
     int rto = (to == 6 || to == 62) ? (to - 1) : (to + 1);
     b->p[stm][R] ^= (1ULL << rfrom) | (1ULL << rto);
     b->occ[stm] ^= (1ULL << rfrom) | (1ULL << rto);
-    b->piece_on[rto] = -1;
-    b->piece_on[rfrom] = stm * 6 + R;
+    b->piece_on[rto] = NO_PIECE;
+    b->piece_on[rfrom] = MAKE_PIECE(stm, R);
+    acc_piece(b, stm, R, rto, -1);
+    acc_piece(b, stm, R, rfrom, 1);
   }
-  int cap = hist[hply].cap;
-  if (cap >= 0) {
-    int c = cap / 6, p = cap % 6;
+  int cap = h->cap;
+  if (cap != NO_PIECE) {
+    int c = PCOLOR(cap), p = PTYPE(cap);
     b->p[c][p] |= to_bb;
     b->occ[c] |= to_bb;
     b->piece_on[to] = cap;
+    acc_piece(b, c, p, to, 1);
   } else if (fl == M_EP) {
     int epsq = stm == W ? to - 8 : to + 8;
     b->p[stm^1][P] |= (1ULL << epsq);
     b->occ[stm^1] |= (1ULL << epsq);
-    b->piece_on[epsq] = (stm^1) * 6 + P;
+    b->piece_on[epsq] = MAKE_PIECE(stm ^ 1, P);
+    acc_piece(b, stm ^ 1, P, epsq, 1);
   }
-  b->castle = hist[hply].castle;
-  b->ep = hist[hply].ep;
-  b->fifty = hist[hply].fifty;
-  b->key = compute_key(b);
+  b->castle = h->castle;
+  b->ep = h->ep;
+  b->fifty = h->fifty;
+  b->since_null = h->since_null;
+  b->key = h->key;
+  b->pawn_key ^= pawn_key_delta(stm, pc, cap, from, to, fl);
+}
+
+int make_move(Position *pos, Move m) {
+  if (pos->hply >= HIST_SIZE) return 0;
+  if (!board_make(&pos->b, m, &pos->hist[pos->hply])) return 0;
+  pos->hply++;
+  return 1;
+}
+
+void unmake_move(Position *pos, Move m) {
+  pos->hply--;
+  board_unmake(&pos->b, m, &pos->hist[pos->hply]);
 }
@@ -0,0 +1,104 @@
+#include "endgame.h"
+#include "types.h"
+
+#include <string.h>
+
+#define ENDGAME_TABLE_SIZE 256
+#define LIGHT_SQUARES 0x55AA55AA55AA55AAULL
+#define FILE_A 0x0101010101010101ULL
+
+typedef int (*EndgameFn)(const Board *b, int strong, int *scale);
+
+typedef struct {
+  U64 key;
+  EndgameFn fn;
+  int strong;
+} EndgameEntry;
+
+static EndgameEntry endgame_table[ENDGAME_TABLE_SIZE];
+
+static inline int endgame_slot(U64 key) {
+  return (int)((key * 0x9E3779B97F4A7C15ULL) >> 56);
+}
+
+static inline int sq_distance(int a, int b) {
+  int df = FILE(a) - FILE(b), dr = RANK(a) - RANK(b);
+  df = df < 0 ? -df : df;
+  dr = dr < 0 ? -dr : dr;
+  return df > dr ? df : dr;
+}
+
+/* No sequence of legal moves can mate: lone minor, or bishops all on one colour. */
+static int eg_insufficient(const Board *b, int strong, int *scale) {
+  U64 bishops = b->p[W][BISHOP] | b->p[B][BISHOP];
+  (void)strong;
+  (void)scale;
+  return (bishops & LIGHT_SQUARES) && (bishops & ~LIGHT_SQUARES) ? EG_NONE : EG_DRAW;
+}
+
+/* Two knights cannot force mate, though the weak side can still blunder into one. */
+static int eg_knnk(const Board *b, int strong, int *scale) {
+  (void)b;
+  (void)strong;
+  *scale = 0;
+  return EG_SCALE;
+}
+
+/* Rook pawns with a bishop that does not control the queening corner are a
+   draw once the defending king is on or next to that corner. */
+static int eg_kbpk(const Board *b, int strong, int *scale) {
+  U64 pawns = b->p[strong][P];
+  (void)scale;
+  if ((pawns & ~FILE_A) && (pawns & ~(FILE_A << 7))) return EG_NONE;
+  int queen_sq = SQ(pawns & FILE_A ? 0 : 7, strong == W ? 7 : 0);
+  int bsq = POP(b->p[strong][BISHOP]);
+  if (!(LIGHT_SQUARES >> bsq & 1) == !(LIGHT_SQUARES >> queen_sq & 1)) return EG_NONE;
+  int ksq = b->king_sq[strong ^ 1];
+  return ksq >= 0 && sq_distance(ksq, queen_sq) <= 1 ? EG_DRAW : EG_NONE;
+}
+
+U64 endgame_mat_key(const char *code, int strong) {
+  static const char names[] = "PNBRQK";
+  U64 key = 0;
+  int c = strong;
+  for (const char *s = code; *s; s++) {
+    if (s != code && *s == 'K') c ^= 1;
+    key += MAT_KEY_UNIT(MAKE_PIECE(c, (int)(strchr(names, *s) - names)));
+  }
+  return key;
+}
+
+static void endgame_add(const char *code, EndgameFn fn) {
+  for (int strong = W; strong <= B; strong++) {
+    U64 key = endgame_mat_key(code, strong);
+    int i = endgame_slot(key);
+    while (endgame_table[i].fn && endgame_table[i].key != key) i = (i + 1) & (ENDGAME_TABLE_SIZE - 1);
+    endgame_table[i].key = key;
+    endgame_table[i].fn = fn;
+    endgame_table[i].strong = strong;
+  }
+}
+
+void endgame_init(void) {
+  memset(endgame_table, 0, sizeof(endgame_table));
+  endgame_add("KK", eg_insufficient);
+  endgame_add("KNK", eg_insufficient);
+  endgame_add("KBK", eg_insufficient);
+  endgame_add("KBBK", eg_insufficient);
+  endgame_add("KBKB", eg_insufficient);
+  endgame_add("KBBKB", eg_insufficient);
+  endgame_add("KBBKBB", eg_insufficient);
+  endgame_add("KNNK", eg_knnk);
+  endgame_add("KBPK", eg_kbpk);
+  endgame_add("KBPPK", eg_kbpk);
+  endgame_add("KBPPPK", eg_kbpk);
+}
+
+int endgame_probe(const Board *b, int *scale) {
+  for (int i = endgame_slot(b->mat_key); endgame_table[i].fn; i = (i + 1) & (ENDGAME_TABLE_SIZE - 1)) {
+    if (endgame_table[i].key != b->mat_key) continue;
+    *scale = EG_SCALE_NORMAL;
+    return endgame_table[i].fn(b, endgame_table[i].strong, scale);
+  }
+  return EG_NONE;
+}
@@ -1,9 +1,44 @@
 #include "eval.h"
-#include "movegen.h"
+#include "endgame.h"
+#include "nnue.h"
 #include "params.h"
 #include "tables.h"
 #include "types.h"
 
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+/* Lockless static-eval cache: each entry packs the upper 48 key bits with the
+   16-bit score in one word, so a racing write can never pair a key with
+   another position's score. Sized by EVAL_CACHE_MB (default 4, 0 disables). */
+static U64 *eval_cache;
+static U64 eval_cache_mask;
+static long long eval_cache_probes, eval_cache_hits;
+
+void eval_cache_init(void) {
+  const char *env = getenv("EVAL_CACHE_MB");
+  U64 mb = (env && *env) ? (U64)atoi(env) : 4;
+  free(eval_cache);
+  eval_cache = NULL;
+  if (!mb) return;
+  U64 n = 1;
+  while (n * 2 * sizeof(U64) <= mb << 20) n *= 2;
+  eval_cache = calloc(n, sizeof(U64));
+  eval_cache_mask = eval_cache ? n - 1 : 0;
+}
+
+void eval_cache_reset_stats(void) {
+  eval_cache_probes = eval_cache_hits = 0;
+}
+
+int eval_cache_hit_pct(void) {
+  return eval_cache_probes ? (int)(eval_cache_hits * 100 / eval_cache_probes) : 0;
+}
+
 static inline int popcount(U64 x) {
 #if defined(_MSC_VER)
   return (int)__popcnt64(x);
@@ -12,53 +47,30 @@ static inline int popcount(U64 x) {
 #endif
 }
 
-static int eval_pawn_structure_side(const Board *b, int c) {
-  int score = 0, sq;
+static Score eval_pawn_structure_side(const Board *b, int c, U64 *passed) {
+  int score = 0;
   U64 pawns = b->p[c][P];
   U64 opp_pawns = b->p[c ^ 1][P];
   for (int f = 0; f < 8; f++) {
-    U64 file_mask = 0x0101010101010101ULL << f;
-    int n = 0;
-    U64 p = pawns & file_mask;
-    while (p) { n++; p &= p - 1; }
+    int n = popcount(pawns & (0x0101010101010101ULL << f));
     if (n >= 2) score -= PARAM_PAWN_DOUBLED_PENALTY;
-    U64 adj_files = (f > 0 ? (0x0101010101010101ULL << (f - 1)) : 0) | (f < 7 ? (0x0101010101010101ULL << (f + 1)) : 0);
-    if (n >= 1 && !(pawns & adj_files)) score -= PARAM_PAWN_ISOLATED_PENALTY;
+    if (n >= 1 && !(pawns & isolated_mask[f])) score -= PARAM_PAWN_ISOLATED_PENALTY;
   }
+  *passed = 0;
   U64 p2 = pawns;
   while (p2) {
-    sq = POP(p2);
+    int sq = POP(p2);
     p2 &= p2 - 1;
-    int r = RANK(sq), fl = FILE(sq);
-    U64 front = 0;
-    if (c == W) {
-      for (int rr = r + 1; rr <= 7; rr++) {
-        front |= 1ULL << SQ(fl, rr);
-        if (fl > 0) front |= 1ULL << SQ(fl - 1, rr);
-        if (fl < 7) front |= 1ULL << SQ(fl + 1, rr);
-      }
-    } else {
-      for (int rr = r - 1; rr >= 0; rr--) {
-        front |= 1ULL << SQ(fl, rr);
-        if (fl > 0) front |= 1ULL << SQ(fl - 1, rr);
-        if (fl < 7) front |= 1ULL << SQ(fl + 1, rr);
-      }
-    }
-    if (!(opp_pawns & front)) {
-      int dist = c == W ? (7 - r) : r;
-      score += PARAM_PASSED_PAWN_BASE + dist * PARAM_PASSED_PAWN_ADVANCE;
-    }
+    if (opp_pawns & passed_mask[c][sq]) continue;
+    *passed |= 1ULL << sq;
+    int dist = c == W ? (7 - RANK(sq)) : RANK(sq);
+    score += PARAM_PASSED_PAWN_BASE + dist * PARAM_PASSED_PAWN_ADVANCE;
   }
-  return c == W ? score : -score;
+  return S(0, c == W ? score : -score);
 }
 
-static int eval_king_safety_side(const Board *b, int c) {
-  int ksq = b->king_sq[c];
-  if (ksq < 0 || ksq > 63) {
-    U64 kbb = b->p[c][K];
-    if (!kbb) return 0;
-    ksq = POP(kbb);
-  }
+static Score eval_king_safety_side(const Board *b, int c, int ksq) {
+  if (ksq < 0) return 0;
   int f = FILE(ksq), r = RANK(ksq);
   int shield = 0;
   U64 pawns = b->p[c][P];
@@ -73,15 +85,34 @@ static int eval_king_safety_side(const Board *b, int c) {
   int open = (b->p[0][P] & file_bb) || (b->p[1][P] & file_bb) ? 0 : 1;
   int pen = -shield + (open ? PARAM_KING_OPEN_FILE_PENALTY : 0);
   if (r == (c == W ? 0 : 7)) pen -= PARAM_KING_BACK_RANK_PENALTY;
-  return c == W ? pen : -pen;
+  return S(c == W ? pen : -pen, 0);
+}
+
+/* Looks up the pawn hash, recomputing the structure score on a key miss and
+   each side's shelter when its king has moved since the entry was filled. */
+static const PawnEntry *pawn_probe(const Board *b) {
+  PawnEntry *pe = &pawn_tt[b->pawn_key & PAWN_HASH_MASK];
+  if (pe->key != b->pawn_key || !b->pawn_key) {
+    pe->key = b->pawn_key;
+    pe->score = (eval_pawn_structure_side(b, W, &pe->passed[W]) + eval_pawn_structure_side(b, B, &pe->passed[B])) * PARAM_PAWN_STRUCTURE_WEIGHT;
+    pe->ksq[W] = pe->ksq[B] = -2;
+  }
+  for (int c = 0; c < 2; c++) {
+    int ksq = b->king_sq[c];
+    if (ksq < 0 && b->p[c][K]) ksq = POP(b->p[c][K]);
+    if (pe->ksq[c] == ksq) continue;
+    pe->ksq[c] = (int8_t)ksq;
+    pe->shelter[c] = eval_king_safety_side(b, c, ksq) * PARAM_KING_SAFETY_WEIGHT;
+  }
+  return pe;
 }
 
-static int eval_bishop_pair_side(const Board *b, int c) {
-  if (popcount(b->p[c][BISHOP]) >= 2) return c == W ? PARAM_BISHOP_PAIR_BONUS : -PARAM_BISHOP_PAIR_BONUS;
+static Score eval_bishop_pair_side(const Board *b, int c) {
+  if (popcount(b->p[c][BISHOP]) >= 2) return S(0, c == W ? PARAM_BISHOP_PAIR_BONUS : -PARAM_BISHOP_PAIR_BONUS);
   return 0;
 }
 
-static int eval_rook_activity_side(const Board *b, int c) {
+static Score eval_rook_activity_side(const Board *b, int c) {
   int score = 0;
   U64 rooks = b->p[c][R];
   while (rooks) {
@@ -96,7 +127,7 @@ static int eval_rook_activity_side(const Board *b, int c) {
     int rank = RANK(sq);
     if ((c == W && rank == 6) || (c == B && rank == 1)) score += PARAM_ROOK_SEVENTH_BONUS;
   }
-  return c == W ? score * PARAM_ROOK_ACTIVITY_WEIGHT : -score * PARAM_ROOK_ACTIVITY_WEIGHT;
+  return S(0, c == W ? score * PARAM_ROOK_ACTIVITY_WEIGHT : -score * PARAM_ROOK_ACTIVITY_WEIGHT);
 }
 
 static int attack_weight_for_piece(int pc) {
@@ -107,49 +138,59 @@ static int attack_weight_for_piece(int pc) {
   return 0;
 }
 
-static int eval_king_attack(const Board *b) {
-  Board tmp = *b;
-  MoveList ml;
-  int score = 0;
+static inline void add_attacks(AttackInfo *ai, int c, int pt, U64 a) {
+  ai->twice[c] |= ai->all[c] & a;
+  ai->all[c] |= a;
+  ai->by_type[c][pt] |= a;
+}
+
+void attack_info_init(const Board *b, AttackInfo *ai) {
+  static const U64 not_a = 0xFEFEFEFEFEFEFEFEULL, not_h = 0x7F7F7F7F7F7F7F7FULL;
+  static const U64 rank3[2] = {0x0000000000FF0000ULL, 0x0000FF0000000000ULL};
+  U64 occ = b->occ[W] | b->occ[B];
   for (int c = 0; c < 2; c++) {
-    int enemy = c ^ 1;
-    int ksq = b->king_sq[enemy];
-    if (ksq < 0 || ksq > 63) {
-      U64 kbb = b->p[enemy][K];
-      if (!kbb) continue;
-      ksq = POP(kbb);
-    }
-    U64 zone = king_att[ksq] | (1ULL << ksq);
-    tmp.side = c;
-    gen_moves(&tmp, &ml);
-    int attacks = 0;
-    for (int i = 0; i < ml.n; i++) {
-      if (!(zone & (1ULL << TO(ml.m[i])))) continue;
-      int from = FROM(ml.m[i]);
-      int piece = b->piece_on[from];
-      if (piece < 0) continue;
-      attacks += attack_weight_for_piece(piece % 6);
+    ai->all[c] = ai->twice[c] = 0;
+    for (int pt = 0; pt < 6; pt++) ai->by_type[c][pt] = 0;
+    int ksq = b->king_sq[c];
+    ai->king_zone[c] = ksq >= 0 ? king_att[ksq] | (1ULL << ksq) : 0;
+  }
+  for (int c = 0; c < 2; c++) {
+    U64 own = b->occ[c], zone = ai->king_zone[c ^ 1];
+    U64 pawns = b->p[c][P];
+    U64 left = c == W ? (pawns & not_a) << 7 : (pawns & not_a) >> 9;
+    U64 right = c == W ? (pawns & not_h) << 9 : (pawns & not_h) >> 7;
+    U64 push = (c == W ? pawns << 8 : pawns >> 8) & ~occ;
+    U64 push2 = (c == W ? (push & rank3[W]) << 8 : (push & rank3[B]) >> 8) & ~occ;
+    add_attacks(ai, c, P, left);
+    add_attacks(ai, c, P, right);
+    int mob = popcount(push) + popcount(push2) + popcount((left | right) & b->occ[c ^ 1]);
+    int zw = (popcount(left & zone & ~own) + popcount(right & zone & ~own)) * PARAM_ATTACK_WEIGHT_PAWN;
+    for (int pt = N; pt <= K; pt++) {
+      U64 bb = b->p[c][pt];
+      while (bb) {
+        int sq = POP(bb);
+        bb &= bb - 1;
+        U64 a = pt == N ? knight_att[sq] : pt == BISHOP ? bishop_attacks(sq, occ)
+              : pt == R ? rook_attacks(sq, occ) : pt == Q ? queen_attacks(sq, occ) : king_att[sq];
+        add_attacks(ai, c, pt, a);
+        mob += popcount(a & ~own);
+        zw += popcount(a & zone & ~own) * attack_weight_for_piece(pt);
+      }
     }
-    int bonus = attacks * PARAM_KING_ATTACK_SCALE;
-    score += (c == W) ? bonus : -bonus;
+    ai->mobility[c] = mob;
+    ai->zone_weight[c] = zw;
   }
-  return score;
 }
 
-static int eval_mobility(const Board *b) {
-  Board tmp = *b;
-  MoveList ml;
-  int score = 0;
-  tmp.side = W;
-  gen_moves(&tmp, &ml);
-  score += ml.n;
-  tmp.side = B;
-  gen_moves(&tmp, &ml);
-  score -= ml.n;
-  return score;
+static Score eval_king_attack(const AttackInfo *ai) {
+  return S((ai->zone_weight[W] - ai->zone_weight[B]) * PARAM_KING_ATTACK_SCALE, 0);
 }
 
-static int eval_center_control(const Board *b) {
+static Score eval_mobility(const AttackInfo *ai) {
+  return S((ai->mobility[W] - ai->mobility[B]) * PARAM_MOBILITY_WEIGHT, 0);
+}
+
+static Score eval_center_control(const AttackInfo *ai) {
   static const U64 center_mask =
       (1ULL << SQ(3, 3)) | (1ULL << SQ(4, 3)) | (1ULL << SQ(3, 4)) | (1ULL << SQ(4, 4));
   static const U64 extended_mask =
@@ -158,80 +199,316 @@ static int eval_center_control(const Board *b) {
       (1ULL << SQ(2, 4)) | (1ULL << SQ(5, 4)) |
       (1ULL << SQ(2, 5)) | (1ULL << SQ(3, 5)) | (1ULL << SQ(4, 5)) | (1ULL << SQ(5, 5)) |
       (1ULL << SQ(2, 6)) | (1ULL << SQ(3, 6)) | (1ULL << SQ(4, 6)) | (1ULL << SQ(5, 6));
-  int cw = popcount(b->occ[W] & center_mask);
-  int cb = popcount(b->occ[B] & center_mask);
-  int ew = popcount(b->occ[W] & extended_mask);
-  int eb = popcount(b->occ[B] & extended_mask);
+  int cw = popcount(ai->all[W] & center_mask);
+  int cb = popcount(ai->all[B] & center_mask);
+  int ew = popcount(ai->all[W] & extended_mask);
+  int eb = popcount(ai->all[B] & extended_mask);
   int score = (cw - cb) * PARAM_CENTER_OCC_BONUS + (ew - eb) * PARAM_CENTER_EXT_BONUS;
-  return score;
+  return S(score, score / 2);
 }
 
 static int eval_phase(const Board *b) {
-  int phase = 0;
-  phase += popcount(b->p[W][N] | b->p[B][N]) * PARAM_PHASE_KNIGHT;
-  phase += popcount(b->p[W][BISHOP] | b->p[B][BISHOP]) * PARAM_PHASE_BISHOP;
-  phase += popcount(b->p[W][R] | b->p[B][R]) * PARAM_PHASE_ROOK;
-  phase += popcount(b->p[W][Q] | b->p[B][Q]) * PARAM_PHASE_QUEEN;
+  int phase = b->phase;
   if (phase > PARAM_PHASE_MAX) phase = PARAM_PHASE_MAX;
   if (phase < 0) phase = 0;
   return phase;
 }
 
-static int eval_hanging_pieces(const Board *b, int c) {
+static Score eval_hanging_pieces(const Board *b, const AttackInfo *ai, int c) {
+  U64 hanging = ai->all[c ^ 1] & ~ai->all[c];
   int penalty = 0;
-  for (int pc = P; pc <= Q; pc++) {
-    U64 bb = b->p[c][pc];
-    while (bb) {
-      int sq = POP(bb);
-      bb &= bb - 1;
-      if (!is_attacked(b, sq, c)) continue;
-      if (is_attacked(b, sq, c ^ 1)) continue;
-      penalty += (piece_val[pc] * PARAM_HANGING_PENALTY_PCT) / 100;
+  for (int pc = P; pc <= Q; pc++)
+    penalty += popcount(b->p[c][pc] & hanging) * ((piece_val[pc] * PARAM_HANGING_PENALTY_PCT) / 100);
+  return S(0, c == W ? -penalty : penalty);
+}
+
+static Score eval_tempo(const Board *b) {
+  int t = b->side == W ? PARAM_TEMPO_BONUS : -PARAM_TEMPO_BONUS;
+  return S(t, t);
+}
+
+/* Tapers a packed score by the game phase, from the side to move's view. */
+static inline int eval_blend(const Board *b, Score s) {
+  int phase = eval_phase(b);
+  int score = (MG_OF(s) * phase + EG_OF(s) * (PARAM_PHASE_MAX - phase)) / PARAM_PHASE_MAX;
+  return b->side == W ? score : -score;
+}
+
+static Score eval_attack_terms(const Board *b) {
+  AttackInfo ai;
+  attack_info_init(b, &ai);
+  Score s = eval_hanging_pieces(b, &ai, W) + eval_hanging_pieces(b, &ai, B);
+  return s + eval_king_attack(&ai) + eval_mobility(&ai) + eval_center_control(&ai);
+}
+
+#if defined(_MSC_VER)
+#define EVAL_INLINE __forceinline
+#else
+#define EVAL_INLINE inline __attribute__((always_inline))
+#endif
+
+/* One body per profile: profile is a constant at each call site, so the terms
+   a profile leaves out are not compiled into it. */
+static EVAL_INLINE int eval_stage(const Board *b, int profile) {
+  Score s = b->psq + eval_tempo(b);
+  if (profile == EVAL_PROFILE_MATERIAL) return eval_blend(b, s);
+  const PawnEntry *pe = pawn_probe(b);
+  s += pe->score + pe->shelter[W] + pe->shelter[B];
+  s += eval_bishop_pair_side(b, W) + eval_bishop_pair_side(b, B);
+  s += eval_rook_activity_side(b, W) + eval_rook_activity_side(b, B);
+  if (profile == EVAL_PROFILE_PAWNS) return eval_blend(b, s);
+  return eval_blend(b, s + eval_attack_terms(b));
+}
+
+static int eval_profile = EVAL_PROFILE_FULL;
+
+static int eval_dispatch(const Board *b) {
+  if (eval_profile == EVAL_PROFILE_MATERIAL) return eval_stage(b, EVAL_PROFILE_MATERIAL);
+  if (eval_profile == EVAL_PROFILE_PAWNS) return eval_stage(b, EVAL_PROFILE_PAWNS);
+  return eval_stage(b, EVAL_PROFILE_FULL);
+}
+
+/* Recognised endings come first. */
+static int eval_full(const Board *b) {
+  int scale, r = endgame_probe(b, &scale);
+  if (r == EG_DRAW) return 0;
+  if (r == EG_SCALE) return eval_dispatch(b) * scale / EG_SCALE_NORMAL;
+  return eval_dispatch(b);
+}
+
+static const char *const eval_profile_names[] = { "material", "pawns", "full" };
+
+const char *eval_profile_name(int profile) {
+  return eval_profile_names[profile];
+}
+
+/* EVAL_PROFILE=material|pawns|full forces a profile; otherwise short move
+   times get the cheaper ones. ms <= 0 means no time limit. The cutoffs are
+   deliberately conservative: make bench (a tactics suite) only shows what a
+   profile costs in depth, about 0.3 plies for full at 100ms and 0.2 from
+   200ms, not what the dropped positional terms are worth. */
+int eval_profile_for_time(int ms) {
+  const char *env = getenv("EVAL_PROFILE");
+  if (env && *env)
+    for (int p = 0; p <= EVAL_PROFILE_FULL; p++)
+      if (!strcmp(env, eval_profile_names[p])) return p;
+  if (ms <= 0) return EVAL_PROFILE_FULL;
+  if (ms <= PARAM_EVAL_MATERIAL_MS) return EVAL_PROFILE_MATERIAL;
+  if (ms <= PARAM_EVAL_PAWNS_MS) return EVAL_PROFILE_PAWNS;
+  return EVAL_PROFILE_FULL;
+}
+
+/* Cached scores belong to the old profile, so a switch empties the cache. */
+void eval_set_profile(int profile) {
+  if (profile == eval_profile) return;
+  eval_profile = profile;
+  if (eval_cache) memset(eval_cache, 0, (eval_cache_mask + 1) * sizeof(U64));
+}
+
+static inline int eval_cache_probe(U64 key, int *score) {
+  U64 v = eval_cache[key & eval_cache_mask];
+  eval_cache_probes++;
+  if ((v ^ key) & ~0xFFFFULL) return 0;
+  eval_cache_hits++;
+  *score = (int16_t)(v & 0xFFFF);
+  return 1;
+}
+
+static inline void eval_cache_store(U64 key, int score) {
+  if (score == (int16_t)score) eval_cache[key & eval_cache_mask] = (key & ~0xFFFFULL) | (uint16_t)score;
+}
+
+int eval(const Board *b) {
+  int score;
+  if (!eval_cache) return eval_full(b);
+  if (eval_cache_probe(b->key, &score)) return score;
+  score = eval_full(b);
+  eval_cache_store(b->key, score);
+  return score;
+}
+
+/* Search-side entry point: the network when one is loaded, else eval(). b is
+   the current board, pos supplies the history for NNUE updates. */
+int evaluate(Position *pos, const Board *b) {
+  int score;
+  if (!nnue_active() || b->king_sq[W] < 0 || b->king_sq[B] < 0) return eval(b);
+  if (eval_cache && eval_cache_probe(b->key, &score)) return score;
+  int scale, r = endgame_probe(b, &scale);
+  score = r == EG_DRAW ? 0 : nnue_evaluate(pos, b);
+  if (r == EG_SCALE) score = score * scale / EG_SCALE_NORMAL;
+  if (eval_cache) eval_cache_store(b->key, score);
+  return score;
+}
+
+#define EVAL_BATCH_BLOCK 64
+#define EVAL_BATCH_MAX_THREADS 64
+
+/* One block of a batch in structure-of-arrays form: each term below runs as
+   a branch-free loop over the block for a fixed side and piece type. */
+typedef struct {
+  U64 bb[2][6][EVAL_BATCH_BLOCK];
+  Score s[EVAL_BATCH_BLOCK];
+  int phase[EVAL_BATCH_BLOCK];
+  int8_t ksq[2][EVAL_BATCH_BLOCK];
+  uint8_t side[EVAL_BATCH_BLOCK];
+} EvalBlock;
+
+static inline U64 file_fill(U64 x) {
+  x |= x << 8; x |= x << 16; x |= x << 32;
+  x |= x >> 8; x |= x >> 16; x |= x >> 32;
+  return x;
+}
+
+/* Squares strictly ahead of x on its own file, from side c's view. */
+static inline U64 file_ahead(U64 x, int c) {
+  if (c == W) { x <<= 8; x |= x << 8; x |= x << 16; x |= x << 32; }
+  else { x >>= 8; x |= x >> 8; x |= x >> 16; x |= x >> 32; }
+  return x;
+}
+
+/* passed_mask[c] of every square in x at once. */
+static inline U64 front_span(U64 x, int c) {
+  x = file_ahead(x, c);
+  return x | ((x << 1) & 0xFEFEFEFEFEFEFEFEULL) | ((x >> 1) & 0x7F7F7F7F7F7F7F7FULL);
+}
+
+static inline int rank_sum(U64 x) {
+  return popcount(x & 0xFF00FF00FF00FF00ULL) + 2 * popcount(x & 0xFFFF0000FFFF0000ULL) + 4 * popcount(x & 0xFFFFFFFF00000000ULL);
+}
+
+/* PST is a per-square lookup, so it is summed while the pieces are decoded. */
+static void batch_decode(EvalBlock *eb, const PackedBoard *in, int n) {
+  memset(eb, 0, sizeof(*eb));
+  for (int i = 0; i < n; i++) {
+    U64 occ = in[i].occ;
+    Score s = 0;
+    int k = 0;
+    eb->ksq[W][i] = eb->ksq[B][i] = -1;
+    while (occ) {
+      int sq = POP(occ);
+      occ &= occ - 1;
+      int pc = (in[i].pieces[k >> 1] >> ((k & 1) * 4)) & 15;
+      k++;
+      if (pc >= NO_PIECE) continue;
+      int c = PCOLOR(pc), p = PTYPE(pc);
+      eb->bb[c][p][i] |= 1ULL << sq;
+      s += c == W ? pst[W][p][sq] : -pst[B][p][sq];
+      if (p == K) eb->ksq[c][i] = (int8_t)sq;
     }
+    eb->s[i] = s;
+    eb->side[i] = in[i].side;
   }
-  return c == W ? -penalty : penalty;
 }
 
-static int eval_material_pst(const Board *b) {
-  int score = 0;
-  for (int c = 0; c < 2; c++) {
-    int sign = (c == W) ? 1 : -1;
+static void batch_material(EvalBlock *eb, int n) {
+  for (int c = 0; c < 2; c++)
     for (int p = 0; p < 6; p++) {
-      U64 bb = b->p[c][p];
-      while (bb) {
-        int sq = POP(bb);
-        bb &= bb - 1;
-        score += sign * (piece_val[p] + pst[c][p][sq]);
+      Score v = c == W ? piece_score[p] : -piece_score[p];
+      int ph = piece_phase[p];
+      for (int i = 0; i < n; i++) {
+        int cnt = popcount(eb->bb[c][p][i]);
+        eb->s[i] += cnt * v;
+        eb->phase[i] += cnt * ph;
       }
     }
+  Score bonus = S(0, PARAM_BISHOP_PAIR_BONUS), tempo = S(PARAM_TEMPO_BONUS, PARAM_TEMPO_BONUS);
+  for (int i = 0; i < n; i++) {
+    eb->s[i] += (popcount(eb->bb[W][BISHOP][i]) >= 2) * bonus - (popcount(eb->bb[B][BISHOP][i]) >= 2) * bonus;
+    eb->s[i] += eb->side[i] == W ? tempo : -tempo;
   }
-  return score;
 }
 
-static int eval_tempo(const Board *b) {
-  return b->side == W ? PARAM_TEMPO_BONUS : -PARAM_TEMPO_BONUS;
+/* Same sums as eval_pawn_structure_side and eval_rook_activity_side, counted
+   from file fills and front spans instead of per-file and per-piece loops. */
+static void batch_files(EvalBlock *eb, int n) {
+  static const U64 rank7[2] = {0x00FF000000000000ULL, 0x000000000000FF00ULL};
+  for (int c = 0; c < 2; c++) {
+    Score pawn_unit = c == W ? S(0, PARAM_PAWN_STRUCTURE_WEIGHT) : -S(0, PARAM_PAWN_STRUCTURE_WEIGHT);
+    Score rook_unit = c == W ? S(0, PARAM_ROOK_ACTIVITY_WEIGHT) : -S(0, PARAM_ROOK_ACTIVITY_WEIGHT);
+    for (int i = 0; i < n; i++) {
+      U64 pawns = eb->bb[c][P][i], opp = eb->bb[c ^ 1][P][i], rooks = eb->bb[c][R][i];
+      U64 files = file_fill(pawns) & 0xFF;
+      U64 doubled = file_fill(pawns & file_ahead(pawns, W)) & 0xFF;
+      U64 isolated = files & ~((files << 1) | (files >> 1));
+      U64 passed = pawns & ~front_span(opp, c ^ 1);
+      int np = popcount(passed);
+      int dist = c == W ? 7 * np - rank_sum(passed) : rank_sum(passed);
+      int ps = np * PARAM_PASSED_PAWN_BASE + dist * PARAM_PASSED_PAWN_ADVANCE
+             - popcount(doubled) * PARAM_PAWN_DOUBLED_PENALTY - popcount(isolated) * PARAM_PAWN_ISOLATED_PENALTY;
+      U64 own_files = file_fill(pawns), opp_files = file_fill(opp);
+      int rs = popcount(rooks & ~own_files & ~opp_files) * PARAM_ROOK_OPEN_FILE_BONUS
+             + popcount(rooks & ~own_files & opp_files) * PARAM_ROOK_SEMI_OPEN_BONUS
+             + popcount(rooks & rank7[c]) * PARAM_ROOK_SEVENTH_BONUS;
+      eb->s[i] += ps * pawn_unit + rs * rook_unit;
+    }
+  }
 }
 
-int eval(const Board *b) {
-  int base = eval_material_pst(b);
-  int pawn = eval_pawn_structure_side(b, W) + eval_pawn_structure_side(b, B);
-  int king_safe = eval_king_safety_side(b, W) + eval_king_safety_side(b, B);
-  int bishop_pair = eval_bishop_pair_side(b, W) + eval_bishop_pair_side(b, B);
-  int rook_act = eval_rook_activity_side(b, W) + eval_rook_activity_side(b, B);
-  int hanging = eval_hanging_pieces(b, W) + eval_hanging_pieces(b, B);
-  int king_attack = eval_king_attack(b);
-  int mobility = eval_mobility(b);
-  int center = eval_center_control(b);
-  int tempo = eval_tempo(b);
+/* King shelter and the attack-map terms stay per position. */
+static void eval_block(EvalBlock *eb, const PackedBoard *in, int n, int *out) {
+  batch_decode(eb, in, n);
+  batch_material(eb, n);
+  batch_files(eb, n);
+  for (int i = 0; i < n; i++) {
+    Board b;
+    memset(&b, 0, sizeof(b));
+    for (int c = 0; c < 2; c++) {
+      for (int p = 0; p < 6; p++) {
+        b.p[c][p] = eb->bb[c][p][i];
+        b.occ[c] |= b.p[c][p];
+      }
+      b.king_sq[c] = eb->ksq[c][i];
+    }
+    for (int pc = 0; pc < NO_PIECE; pc++) b.mat_key += (U64)popcount(b.p[PCOLOR(pc)][PTYPE(pc)]) * MAT_KEY_UNIT(pc);
+    b.side = eb->side[i];
+    b.phase = (int16_t)eb->phase[i];
+    int scale, r = endgame_probe(&b, &scale);
+    if (r == EG_DRAW) { out[i] = 0; continue; }
+    Score s = eb->s[i] + eval_attack_terms(&b);
+    s += (eval_king_safety_side(&b, W, b.king_sq[W]) + eval_king_safety_side(&b, B, b.king_sq[B])) * PARAM_KING_SAFETY_WEIGHT;
+    out[i] = eval_blend(&b, s);
+    if (r == EG_SCALE) out[i] = out[i] * scale / EG_SCALE_NORMAL;
+  }
+}
 
-  int phase = eval_phase(b);
-  int mg_w = phase;
-  int eg_w = PARAM_PHASE_MAX - phase;
+typedef struct {
+  const PackedBoard *in;
+  int *out;
+  int n;
+  int next;
+} EvalBatchJob;
 
-  int mg = king_safe * PARAM_KING_SAFETY_WEIGHT + king_attack + mobility * PARAM_MOBILITY_WEIGHT + tempo + center;
-  int eg = pawn * PARAM_PAWN_STRUCTURE_WEIGHT + rook_act + bishop_pair + hanging + tempo + center / 2;
+static void *eval_batch_worker(void *arg) {
+  EvalBatchJob *job = arg;
+  EvalBlock *eb = malloc(sizeof(EvalBlock));
+  if (!eb) return NULL;
+  for (;;) {
+    int i = __atomic_fetch_add(&job->next, EVAL_BATCH_BLOCK, __ATOMIC_RELAXED);
+    if (i >= job->n) break;
+    eval_block(eb, job->in + i, job->n - i < EVAL_BATCH_BLOCK ? job->n - i : EVAL_BATCH_BLOCK, job->out + i);
+  }
+  free(eb);
+  return NULL;
+}
 
-  int score = base + (mg * mg_w + eg * eg_w) / PARAM_PHASE_MAX;
-  if (b->side == B) score = -score;
-  return score;
+/* Classic eval of n packed positions, side to move's view, matching eval().
+   Bypasses the pawn hash and eval cache so workers share no state; thread
+   count is EVAL_THREADS, default one per online CPU. */
+void eval_batch(const PackedBoard *in, int n, int *out) {
+  const char *env = getenv("EVAL_THREADS");
+  int threads = (env && *env) ? atoi(env) : 0;
+#if defined(_SC_NPROCESSORS_ONLN)
+  if (threads < 1) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if (threads > (n + EVAL_BATCH_BLOCK - 1) / EVAL_BATCH_BLOCK) threads = (n + EVAL_BATCH_BLOCK - 1) / EVAL_BATCH_BLOCK;
+  if (threads > EVAL_BATCH_MAX_THREADS) threads = EVAL_BATCH_MAX_THREADS;
+  if (threads < 1) threads = 1;
+  EvalBatchJob job = { in, out, n, 0 };
+  pthread_t tid[EVAL_BATCH_MAX_THREADS];
+  int started = 0;
+  for (int t = 1; t < threads; t++) {
+    if (pthread_create(&tid[started], NULL, eval_batch_worker, &job) == 0) started++;
+  }
+  eval_batch_worker(&job);
+  for (int t = 0; t < started; t++) pthread_join(tid[t], NULL);
 }
@@ -2,6 +2,7 @@
 #include "board.h"
 #include "movegen.h"
 #include "params.h"
+#include "perft.h"
 #include "search.h"
 #include "uci.h"
 #include "types.h"
@@ -53,8 +54,8 @@ static int selfplay_depth(void) {
 }
 
 static void selfplay_mode(void) {
-  Board b;
-  board_reset(&b);
+  Position pos;
+  board_reset(&pos);
   long long ply = 0;
   int games = 0;
   int depth_limit = selfplay_depth();
@@ -62,30 +63,30 @@ static void selfplay_mode(void) {
   int save_interval = 50;
   fprintf(stderr, "Self-play started (depth<=%d, move_ms=%d). Press Ctrl-C to stop.\n", depth_limit, move_ms);
   while (1) {
-    board_sync(&b);
+    board_sync(&pos.b);
     MoveList ml;
-    gen_moves(&b, &ml);
-    if (ml.n == 0 || b.fifty >= 100 || board_is_repetition(&b)) {
+    gen_legal(&pos.b, &ml, GEN_ALL);
+    if (ml.n == 0 || pos.b.fifty >= 100 || board_is_repetition(&pos, &pos.b)) {
       games++;
-      board_reset(&b);
+      board_reset(&pos);
       continue;
     }
     int score = 0;
     char buf[16];
     snprintf(buf, sizeof buf, "%d", move_ms);
     setenv("MOVE_TIME_MS", buf, 1);
-    Move best = search(&b, depth_limit, &score);
+    Move best = search(&pos, depth_limit, &score);
     Move fallback = 0;
     for (int i = 0; i < ml.n; i++) {
-      if (move_is_legal(&b, ml.m[i])) { fallback = ml.m[i]; break; }
+      if (move_is_legal(&pos.b, ml.m[i])) { fallback = ml.m[i]; break; }
     }
-    if (!best || !move_is_legal(&b, best)) best = fallback;
+    if (!best || !move_is_legal(&pos.b, best)) best = fallback;
     if (!best) {
       games++;
-      board_reset(&b);
+      board_reset(&pos);
       continue;
     }
-    make_move(&b, best);
+    make_move(&pos, best);
     ply++;
     if (ply % save_interval == 0) {
       fprintf(stderr, "self-play games=%d ply=%lld depth=%d nodes=%lld\n",
@@ -159,6 +160,15 @@ static int starts_with_cmd(const char *s, const char *cmd) {
   return strncmp(s, cmd, n) == 0;
 }
 
+/* Piece values, the board's material sums and cached evals depend on the
+   parameters, so rebuild them after a setoption. */
+static void params_changed(Board *b) {
+  init_tables();
+  board_compute_acc(b);
+  eval_cache_init();
+  memset(pawn_tt, 0, sizeof(pawn_tt));
+}
+
 static Move move_stack[HIST_SIZE];
 static int side_stack[HIST_SIZE];
 static int move_top = 0;
@@ -194,30 +204,143 @@ static Move last_move_by_side(int side) {
   return 0;
 }
 
+/* perft [divide] <depth> [fen] */
+static int perft_mode(int argc, char **argv) {
+  static Position pos;
+  int i = 2, divide = 0;
+  if (i < argc && str_eq_ignore_case(argv[i], "divide")) { divide = 1; i++; }
+  if (i >= argc || atoi(argv[i]) < 0) {
+    fprintf(stderr, "usage: engine perft [divide] <depth> [fen]\n");
+    return 1;
+  }
+  int depth = atoi(argv[i++]);
+  if (i < argc && is_fen(argv[i])) board_from_fen(&pos, argv[i]);
+  else board_reset(&pos);
+  perft_run(&pos, depth, divide);
+  return 0;
+}
+
+/* evalbatch <file>: one FEN per line in, one classic eval per line out. */
+static int evalbatch_mode(int argc, char **argv) {
+  static Position pos;
+  FILE *f = argc > 2 ? fopen(argv[2], "r") : NULL;
+  if (!f) {
+    fprintf(stderr, "usage: engine evalbatch <fen-file>\n");
+    return 1;
+  }
+  PackedBoard *in = NULL;
+  int n = 0, cap = 0;
+  char buf[256];
+  while (fgets(buf, sizeof buf, f)) {
+    trim_newline(buf);
+    if (!is_fen(buf)) continue;
+    if (n == cap) {
+      cap = cap ? cap * 2 : 4096;
+      PackedBoard *grown = realloc(in, (size_t)cap * sizeof(PackedBoard));
+      if (!grown) { fclose(f); free(in); return 1; }
+      in = grown;
+    }
+    board_from_fen(&pos, buf);
+    if (!board_pack(&pos.b, &in[n])) {
+      fprintf(stderr, "evalbatch: more than 32 pieces: %s\n", buf);
+      fclose(f);
+      free(in);
+      return 1;
+    }
+    n++;
+  }
+  fclose(f);
+  int *out = malloc((size_t)(n ? n : 1) * sizeof(int));
+  if (!out) { free(in); return 1; }
+  clock_t start = clock();
+  eval_batch(in, n, out);
+  long long ms = (long long)(clock() - start) * 1000 / CLOCKS_PER_SEC;
+  for (int i = 0; i < n; i++) printf("%d\n", out[i]);
+  fprintf(stderr, "evalbatch: %d positions %lldms\n", n, ms);
+  free(in);
+  free(out);
+  return 0;
+}
+
+/* nnuecheck [plies]: random games on two interleaved positions; every child
+   of each game position, and the game position itself now and then, is
+   checked against a full refresh. Exits 1 on a mismatch. */
+static int nnuecheck_mode(int argc, char **argv) {
+  static Position pos[2];
+  if (!nnue_active()) {
+    fprintf(stderr, "usage: EVAL_NNUE=<file> engine nnuecheck [plies]\n");
+    return 1;
+  }
+  int plies = argc > 2 ? atoi(argv[2]) : 2000;
+  U64 seed = 0x9E3779B97F4A7C15ULL;
+  long long checked = 0, bad = 0;
+  board_reset(&pos[0]);
+  board_reset(&pos[1]);
+  for (int i = 0; i < plies; i++) {
+    Position *p = &pos[i & 1];
+    MoveList ml;
+    gen_legal(&p->b, &ml, GEN_ALL);
+    if (!ml.n || p->hply >= HIST_SIZE - 1 || p->b.fifty >= 100) {
+      board_reset(p);
+      continue;
+    }
+    for (int j = 0; j < ml.n; j++) {
+      if (!make_move(p, ml.m[j])) continue;
+      bad += !nnue_verify(p);
+      checked++;
+      unmake_move(p, ml.m[j]);
+    }
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    make_move(p, ml.m[seed % (U64)ml.n]);
+    if ((seed >> 32) % 4 == 0) {
+      bad += !nnue_verify(p);
+      checked++;
+    }
+  }
+  printf("nnuecheck: %s %lld positions %lld mismatches\n", nnue_kernel_name(), checked, bad);
+  return bad != 0;
+}
+
+static const char *take_slider_arg(int *argc, char **argv) {
+  const char *v = NULL;
+  int j = 1;
+  for (int i = 1; i < *argc; i++) {
+    if (starts_with_cmd(argv[i], "--slider=")) v = argv[i] + 9;
+    else argv[j++] = argv[i];
+  }
+  *argc = j;
+  return v;
+}
+
 int main(int argc, char **argv) {
-  Board b;
+  Position pos;
   setvbuf(stdout, NULL, _IOLBF, 0);
   setvbuf(stderr, NULL, _IOLBF, 0);
-  engine_init();
+  engine_init(take_slider_arg(&argc, argv));
+  if (argc > 1 && str_eq_ignore_case(argv[1], "perft")) return perft_mode(argc, argv);
+  if (argc > 1 && str_eq_ignore_case(argv[1], "evalbatch")) return evalbatch_mode(argc, argv);
+  if (argc > 1 && str_eq_ignore_case(argv[1], "nnuecheck")) return nnuecheck_mode(argc, argv);
   init_tt_cache();
 
   if (argc > 1 && is_interactive_arg(argv[1])) {
     int us = our_color_from_arg(argv[1]);
-    board_reset(&b);
+    board_reset(&pos);
     reset_move_stack();
     Move last_engine_move = 0;
     for (;;) {
-      if (b.side == us) {
-        board_sync(&b);
+      if (pos.b.side == us) {
+        board_sync(&pos.b);
         MoveList ml;
-        gen_moves(&b, &ml);
+        gen_legal(&pos.b, &ml, GEN_ALL);
         if (ml.n == 0) break;
         fprintf(stderr, "Thinking... ");
         fflush(stderr);
         int score;
-        Board b_search = b;
+        Position pos_search = pos;
         clock_t start = clock();
-        Move best = search(&b_search, PARAM_DEFAULT_SEARCH_DEPTH, &score);
+        Move best = search(&pos_search, PARAM_DEFAULT_SEARCH_DEPTH, &score);
         int depth_done = search_last_completed_depth();
         long long nodes = search_last_nodes();
         clock_t end = clock();
@@ -225,26 +348,26 @@ int main(int argc, char **argv) {
         long long kn = nodes / 1000;
         long long nps = 0;
         if (ms > 0) nps = (nodes * 1000) / ms;
-        if (!best || !move_is_legal(&b, best)) {
+        if (!best || !move_is_legal(&pos.b, best)) {
           MoveList ml_fallback;
-          gen_moves(&b, &ml_fallback);
+          gen_moves(&pos.b, &ml_fallback);
           for (int i = 0; i < ml_fallback.n; i++) {
-            if (move_is_legal(&b, ml_fallback.m[i])) { best = ml_fallback.m[i]; break; }
+            if (move_is_legal(&pos.b, ml_fallback.m[i])) { best = ml_fallback.m[i]; break; }
           }
         }
-        if (!best || !move_is_legal(&b, best)) {
-          printf("(none) %lldms d=%d kn=%lld nps=%lld\n", ms, depth_done, kn, nps);
+        if (!best || !move_is_legal(&pos.b, best)) {
+          printf("(none) %lldms d=%d kn=%lld nps=%lld evhit=%d%%\n", ms, depth_done, kn, nps, eval_cache_hit_pct());
           fflush(stdout);
           break;
         }
-        printf("%s %lldms d=%d kn=%lld nps=%lld\n", move_to_uci(best), ms, depth_done, kn, nps);
+        printf("%s %lldms d=%d kn=%lld nps=%lld evhit=%d%%\n", move_to_uci(best), ms, depth_done, kn, nps, eval_cache_hit_pct());
         fflush(stdout);
-        if (!make_move(&b, best)) break;
+        if (!make_move(&pos, best)) break;
         record_move(best, us);
         last_engine_move = best;
-        board_sync(&b);
+        board_sync(&pos.b);
       } else {
-        board_sync(&b);
+        board_sync(&pos.b);
         char buf[128];
         if (!fgets(buf, sizeof buf, stdin)) break;
         trim_newline(buf);
@@ -253,7 +376,7 @@ int main(int argc, char **argv) {
           if (peek_last_side() == us) {
             Move m;
             pop_move(&m, NULL);
-            unmake_move(&b, m);
+            unmake_move(&pos, m);
             last_engine_move = last_move_by_side(us);
           } else {
             fprintf(stderr, "no engine move to undo\n");
@@ -264,15 +387,25 @@ int main(int argc, char **argv) {
           if (move_top >= 2 && side_stack[move_top - 1] == us && side_stack[move_top - 2] == (us ^ 1)) {
             Move m;
             pop_move(&m, NULL);
-            unmake_move(&b, m);
+            unmake_move(&pos, m);
             pop_move(&m, NULL);
-            unmake_move(&b, m);
+            unmake_move(&pos, m);
             last_engine_move = last_move_by_side(us);
           } else {
             fprintf(stderr, "no opponent move to undo\n");
           }
           continue;
         }
+        if (starts_with_cmd(buf, "setoption name ")) {
+          char name[64];
+          int value;
+          if (sscanf(buf + 15, "%63s value %d", name, &value) != 2 || !params_set(name, value)) {
+            fprintf(stderr, "invalid option: %s\n", buf + 15);
+            continue;
+          }
+          params_changed(&pos.b);
+          continue;
+        }
         if (starts_with_cmd(buf, "force ") || starts_with_cmd(buf, "play ")) {
           const char *arg = buf + 6;
           if (peek_last_side() != us || !last_engine_move) {
@@ -282,20 +415,20 @@ int main(int argc, char **argv) {
           {
             Move m;
             pop_move(&m, NULL);
-            unmake_move(&b, m);
+            unmake_move(&pos, m);
           }
-          search_set_root_exclude(last_engine_move, b.key, b.ply);
+          search_set_root_exclude(last_engine_move, pos.b.key, pos.b.ply);
           tt_clear();
           Move forced;
-          if (!uci_to_move(&b, arg, &forced)) {
+          if (!uci_to_move(&pos.b, arg, &forced)) {
             fprintf(stderr, "invalid forced move: %s\n", uci_last_error());
-            make_move(&b, last_engine_move);
+            make_move(&pos, last_engine_move);
             record_move(last_engine_move, us);
             continue;
           }
-          if (!make_move(&b, forced)) {
+          if (!make_move(&pos, forced)) {
             fprintf(stderr, "forced move could not be applied\n");
-            make_move(&b, last_engine_move);
+            make_move(&pos, last_engine_move);
             record_move(last_engine_move, us);
             continue;
           }
@@ -306,13 +439,13 @@ int main(int argc, char **argv) {
           continue;
         }
         Move m;
-        if (!uci_to_move(&b, buf, &m)) {
+        if (!uci_to_move(&pos.b, buf, &m)) {
           fprintf(stderr, "invalid move: %s\n", uci_last_error());
           continue;
         }
-        if (!make_move(&b, m)) {
-          board_sync(&b);
-          if (!make_move(&b, m)) {
+        if (!make_move(&pos, m)) {
+          board_sync(&pos.b);
+          if (!make_move(&pos, m)) {
             fprintf(stderr, "invalid move: could not apply move\n");
             continue;
           }
@@ -329,13 +462,13 @@ int main(int argc, char **argv) {
   }
 
   if (argc > 1 && is_fen(argv[1])) {
-    board_from_fen(&b, argv[1]);
+    board_from_fen(&pos, argv[1]);
   } else {
-    board_reset(&b);
+    board_reset(&pos);
   }
   int score;
   clock_t start = clock();
-  Move best = search(&b, PARAM_DEFAULT_SEARCH_DEPTH, &score);
+  Move best = search(&pos, PARAM_DEFAULT_SEARCH_DEPTH, &score);
   int depth_done = search_last_completed_depth();
   long long nodes = search_last_nodes();
   clock_t end = clock();
@@ -343,17 +476,17 @@ int main(int argc, char **argv) {
   long long kn = nodes / 1000;
   long long nps = 0;
   if (ms > 0) nps = (nodes * 1000) / ms;
-  if (!best || !move_is_legal(&b, best)) {
+  if (!best || !move_is_legal(&pos.b, best)) {
     MoveList ml_fallback;
-    gen_moves(&b, &ml_fallback);
+    gen_moves(&pos.b, &ml_fallback);
     for (int i = 0; i < ml_fallback.n; i++) {
-      if (move_is_legal(&b, ml_fallback.m[i])) { best = ml_fallback.m[i]; break; }
+      if (move_is_legal(&pos.b, ml_fallback.m[i])) { best = ml_fallback.m[i]; break; }
     }
   }
   if (best) {
-    printf("%s %lldms d=%d kn=%lld nps=%lld\n", move_to_uci(best), ms, depth_done, kn, nps);
+    printf("%s %lldms d=%d kn=%lld nps=%lld evhit=%d%%\n", move_to_uci(best), ms, depth_done, kn, nps, eval_cache_hit_pct());
   } else {
-    printf("(none) %lldms d=%d kn=%lld nps=%lld\n", ms, depth_done, kn, nps);
+    printf("(none) %lldms d=%d kn=%lld nps=%lld evhit=%d%%\n", ms, depth_done, kn, nps, eval_cache_hit_pct());
   }
   fflush(stdout);
   return 0;
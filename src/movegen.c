@@ -3,101 +3,32 @@
 #include "tables.h"
 #include "types.h"
 
-static const int step[8] = {-8, -7, 1, 9, 8, 7, -1, -9};
-static const int rook_dirs[4] = {0, 2, 4, 6};
-static const int bishop_dirs[4] = {1, 3, 5, 7};
-
-static int first_blocker(int sq, int dir, U64 occ) {
-  int d = step[dir];
-  int f = FILE(sq), r = RANK(sq);
-  int i;
-  if (d == 1 || d == -1) {
-    for (i = sq + d; i >= 0 && i < 64 && (i / 8) == r; i += d) {
-      if (occ & (1ULL << i)) return i;
-    }
-  } else if (d == 8 || d == -8) {
-    for (i = sq + d; i >= 0 && i < 64 && (i % 8) == f; i += d) {
-      if (occ & (1ULL << i)) return i;
-    }
-  } else {
-    for (i = sq + d; i >= 0 && i < 64; i += d) {
-      int df = FILE(i) - f, dr = RANK(i) - r;
-      if (df < -1 || df > 1 || dr < -1 || dr > 1) break;
-      if (occ & (1ULL << i)) return i;
-      f = FILE(i);
-      r = RANK(i);
-    }
-  }
-  return -1;
+/* Attackers of both colours on sq through occ; callers mask with occ. */
+static U64 see_attackers(const Board *b, int sq, U64 occ) {
+  U64 rq = b->p[W][R] | b->p[B][R] | b->p[W][Q] | b->p[B][Q];
+  U64 bq = b->p[W][BISHOP] | b->p[B][BISHOP] | b->p[W][Q] | b->p[B][Q];
+  return (inv_pawn_att[W][sq] & b->p[W][P]) | (inv_pawn_att[B][sq] & b->p[B][P]) |
+         (knight_att[sq] & (b->p[W][N] | b->p[B][N])) |
+         (king_att[sq] & (b->p[W][K] | b->p[B][K])) |
+         (rook_attacks(sq, occ) & rq) | (bishop_attacks(sq, occ) & bq);
 }
 
-static U64 attackers_to(U64 occ, int sq, int side, U64 pieces[2][6]) {
-  U64 att = 0;
-  att |= inv_pawn_att[side][sq] & pieces[side][P];
-  att |= knight_att[sq] & pieces[side][N];
-  att |= king_att[sq] & pieces[side][K];
-  for (int i = 0; i < 4; i++) {
-    int d = rook_dirs[i];
-    int bq = first_blocker(sq, d, occ);
-    if (bq >= 0) {
-      U64 bb = 1ULL << bq;
-      if (bb & (pieces[side][R] | pieces[side][Q])) att |= bb;
-    }
-  }
-  for (int i = 0; i < 4; i++) {
-    int d = bishop_dirs[i];
-    int bq = first_blocker(sq, d, occ);
-    if (bq >= 0) {
-      U64 bb = 1ULL << bq;
-      if (bb & (pieces[side][BISHOP] | pieces[side][Q])) att |= bb;
-    }
+/* Picks side's least valuable attacker from att; returns its type and sets *bb to its square. */
+static int see_least(const Board *b, U64 att, int side, U64 *bb) {
+  for (int p = P; p <= K; p++) {
+    U64 x = att & b->p[side][p];
+    if (x) { *bb = x & (0 - x); return p; }
   }
-  att &= ~(1ULL << sq);
-  return att;
-}
-
-static int least_attacker_sq(U64 att, int side, U64 pieces[2][6]) {
-  U64 bb = att & pieces[side][P];
-  if (bb) return POP(bb);
-  bb = att & pieces[side][N];
-  if (bb) return POP(bb);
-  bb = att & pieces[side][BISHOP];
-  if (bb) return POP(bb);
-  bb = att & pieces[side][R];
-  if (bb) return POP(bb);
-  bb = att & pieces[side][Q];
-  if (bb) return POP(bb);
-  bb = att & pieces[side][K];
-  if (bb) return POP(bb);
   return -1;
 }
 
-
-static inline U64 slide_att(int sq, int dir, U64 occ) {
+/* Adds the sliders uncovered behind a piece that just left the exchange. */
+static U64 see_xrays(const Board *b, int sq, int p, U64 occ) {
   U64 att = 0;
-  int d = step[dir];
-  int f = FILE(sq), r = RANK(sq);
-  int i;
-  if (d == 1 || d == -1) {
-    for (i = sq + d; i >= 0 && i < 64 && (i / 8) == r; i += d) {
-      att |= 1ULL << i;
-      if (occ & (1ULL << i)) break;
-    }
-  } else if (d == 8 || d == -8) {
-    for (i = sq + d; i >= 0 && i < 64 && (i % 8) == f; i += d) {
-      att |= 1ULL << i;
-      if (occ & (1ULL << i)) break;
-    }
-  } else {
-    for (i = sq + d; i >= 0 && i < 64; i += d) {
-      int df = FILE(i) - f, dr = RANK(i) - r;
-      if (df < -1 || df > 1 || dr < -1 || dr > 1) break;
-      att |= 1ULL << i;
-      if (occ & (1ULL << i)) break;
-      f = FILE(i);
-      r = RANK(i);
-    }
-  }
+  if (p == P || p == BISHOP || p == Q)
+    att |= bishop_attacks(sq, occ) & (b->p[W][BISHOP] | b->p[B][BISHOP] | b->p[W][Q] | b->p[B][Q]);
+  if (p == R || p == Q)
+    att |= rook_attacks(sq, occ) & (b->p[W][R] | b->p[B][R] | b->p[W][Q] | b->p[B][Q]);
   return att;
 }
 
@@ -108,7 +39,7 @@ static void add_move(MoveList *ml, Move m) {
 int is_attacked(const Board *b, int sq, int side) {
   if (sq < 0 || sq >= 64) return 0;
   U64 occ = 0;
-  int c, p, i;
+  int c, p;
   int opp = side ^ 1;
   for (c = 0; c < 2; c++) {
     for (p = 0; p < 6; p++) {
@@ -118,14 +49,8 @@ int is_attacked(const Board *b, int sq, int side) {
   if (inv_pawn_att[opp][sq] & b->p[opp][P]) return 1;
   if (knight_att[sq] & b->p[opp][N]) return 1;
   if (king_att[sq] & b->p[opp][K]) return 1;
-  for (i = 0; i < 4; i++) {
-    int d = rook_dirs[i];
-    if (slide_att(sq, d, occ) & (b->p[opp][R] | b->p[opp][Q])) return 1;
-  }
-  for (i = 0; i < 4; i++) {
-    int d = bishop_dirs[i];
-    if (slide_att(sq, d, occ) & (b->p[opp][BISHOP] | b->p[opp][Q])) return 1;
-  }
+  if (rook_attacks(sq, occ) & (b->p[opp][R] | b->p[opp][Q])) return 1;
+  if (bishop_attacks(sq, occ) & (b->p[opp][BISHOP] | b->p[opp][Q])) return 1;
   return 0;
 }
 
@@ -147,7 +72,7 @@ void gen_moves(const Board *b, MoveList *ml) {
   while (p) {
     from = POP(p);
     p &= p - 1;
-    to_bb = (pawn_push[stm][from] & empty);
+    to_bb = (RANK(from) == (stm ? 1 : 6)) ? 0 : (pawn_push[stm][from] & empty);
     if (stm == W) {
       if (to_bb & (1ULL << (from + 8))) add_move(ml, MOVE(from, from + 8, M_NORMAL));
       if ((to_bb & (1ULL << (from + 16))) && (empty & (1ULL << (from + 8)))) add_move(ml, MOVE(from, from + 16, M_NORMAL));
@@ -171,17 +96,15 @@ void gen_moves(const Board *b, MoveList *ml) {
     while (to_bb) { to = POP(to_bb); to_bb &= to_bb - 1; add_move(ml, MOVE(from, to, M_NORMAL)); }
   }
   for (int pc = BISHOP; pc <= Q; pc++) {
-    int ndir = (pc == BISHOP) ? 4 : (pc == R) ? 4 : 8;
-    const int *dirs = (pc == BISHOP) ? bishop_dirs : (pc == R) ? rook_dirs : (const int[]){0,1,2,3,4,5,6,7};
     p = b->p[stm][pc];
     while (p) {
       from = POP(p);
       p &= p - 1;
-      for (int i = 0; i < ndir; i++) {
-        int d = dirs[i];
-        to_bb = slide_att(from, d, occ_all) & ~b->occ[stm];
-        while (to_bb) { to = POP(to_bb); to_bb &= to_bb - 1; add_move(ml, MOVE(from, to, M_NORMAL)); }
-      }
+      if (pc == BISHOP) to_bb = bishop_attacks(from, occ_all);
+      else if (pc == R) to_bb = rook_attacks(from, occ_all);
+      else to_bb = queen_attacks(from, occ_all);
+      to_bb &= ~b->occ[stm];
+      while (to_bb) { to = POP(to_bb); to_bb &= to_bb - 1; add_move(ml, MOVE(from, to, M_NORMAL)); }
     }
   }
   p = b->p[stm][K];
@@ -212,33 +135,280 @@ void gen_captures(const Board *b, MoveList *ml) {
     int to = TO(m);
     int cap = b->piece_on[to];
     int fl = FLAGS(m);
-    if (cap >= 0 || fl == M_EP) ml->m[j++] = m;
+    if (cap != NO_PIECE || fl == M_EP) ml->m[j++] = m;
   }
   ml->n = j;
 }
 
+static U64 attackers_of(const Board *b, int sq, int side, U64 occ) {
+  return (inv_pawn_att[side][sq] & b->p[side][P]) |
+         (knight_att[sq] & b->p[side][N]) |
+         (king_att[sq] & b->p[side][K]) |
+         (rook_attacks(sq, occ) & (b->p[side][R] | b->p[side][Q])) |
+         (bishop_attacks(sq, occ) & (b->p[side][BISHOP] | b->p[side][Q]));
+}
+
+U64 board_checkers(const Board *b) {
+  int ksq = b->king_sq[b->side];
+  if (ksq < 0 || ksq > 63) return 0;
+  return attackers_of(b, ksq, b->side ^ 1, b->occ[0] | b->occ[1]);
+}
+
+/* Pieces of either colour that alone stand between ksq and a slider of side. */
+static U64 slider_blockers(const Board *b, int ksq, int side) {
+  U64 occ = b->occ[0] | b->occ[1];
+  U64 snipers = (rook_attacks(ksq, 0) & (b->p[side][R] | b->p[side][Q])) |
+                (bishop_attacks(ksq, 0) & (b->p[side][BISHOP] | b->p[side][Q]));
+  U64 blockers = 0;
+  while (snipers) {
+    int s = POP(snipers);
+    snipers &= snipers - 1;
+    U64 blk = between_bb[ksq][s] & occ;
+    if (blk && !(blk & (blk - 1))) blockers |= blk;
+  }
+  return blockers;
+}
+
+U64 board_pinned(const Board *b, int side) {
+  int ksq = b->king_sq[side];
+  if (ksq < 0 || ksq > 63) return 0;
+  return slider_blockers(b, ksq, side ^ 1) & b->occ[side];
+}
+
+void check_info_init(const Board *b, CheckInfo *ci) {
+  int stm = b->side;
+  int ksq = b->king_sq[stm ^ 1];
+  U64 occ = b->occ[0] | b->occ[1];
+  ci->ksq = ksq;
+  if (ksq < 0 || ksq > 63) {
+    for (int p = 0; p < 6; p++) ci->check_sq[p] = 0;
+    ci->discovered = 0;
+    return;
+  }
+  ci->check_sq[P] = inv_pawn_att[stm][ksq];
+  ci->check_sq[N] = knight_att[ksq];
+  ci->check_sq[BISHOP] = bishop_attacks(ksq, occ);
+  ci->check_sq[R] = rook_attacks(ksq, occ);
+  ci->check_sq[Q] = ci->check_sq[BISHOP] | ci->check_sq[R];
+  ci->check_sq[K] = 0;
+  ci->discovered = slider_blockers(b, ksq, stm) & b->occ[stm];
+}
+
+int move_gives_check(const Board *b, const CheckInfo *ci, Move m) {
+  int from = FROM(m), to = TO(m), fl = FLAGS(m);
+  int stm = b->side, ksq = ci->ksq;
+  if (ksq < 0 || ksq > 63) return 0;
+  U64 from_bb = 1ULL << from, to_bb = 1ULL << to;
+  int pc = PTYPE(b->piece_on[from]);
+  if ((ci->discovered & from_bb) && !(line_bb[ksq][from] & to_bb)) return 1;
+  U64 occ = (b->occ[0] | b->occ[1]) ^ from_bb;
+  U64 rq = b->p[stm][R] | b->p[stm][Q], bq = b->p[stm][BISHOP] | b->p[stm][Q];
+  switch (fl) {
+    case M_PROMO: {
+      int pr = PROMO_PC(m) + 1;
+      occ |= to_bb;
+      if (pr == N) return (knight_att[to] >> ksq) & 1;
+      U64 att = 0;
+      if (pr == BISHOP || pr == Q) att |= bishop_attacks(to, occ);
+      if (pr == R || pr == Q) att |= rook_attacks(to, occ);
+      return (att >> ksq) & 1;
+    }
+    case M_EP: {
+      if (ci->check_sq[P] & to_bb) return 1;
+      occ ^= (1ULL << (stm == W ? to - 8 : to + 8));
+      occ |= to_bb;
+      return ((rook_attacks(ksq, occ) & rq) | (bishop_attacks(ksq, occ) & bq)) != 0;
+    }
+    case M_CASTLE: {
+      int rfrom = (to == 6 || to == 62) ? (to + 1) : (to - 2);
+      int rto = (to == 6 || to == 62) ? (to - 1) : (to + 1);
+      occ = (occ ^ (1ULL << rfrom)) | to_bb | (1ULL << rto);
+      return (rook_attacks(rto, occ) >> ksq) & 1;
+    }
+    default:
+      return (ci->check_sq[pc] & to_bb) != 0;
+  }
+}
+
+static void add_promos(MoveList *ml, int from, int to) {
+  for (int pr = Q; pr >= N; pr--) add_move(ml, MOVE(from, to, M_PROMO) | ((pr - 1) << 14));
+}
+
+static int ep_is_legal(const Board *b, int from, int ksq) {
+  int stm = b->side, opp = stm ^ 1;
+  int capsq = stm == W ? b->ep - 8 : b->ep + 8;
+  U64 occ = ((b->occ[0] | b->occ[1]) ^ (1ULL << from) ^ (1ULL << capsq)) | (1ULL << b->ep);
+  if (rook_attacks(ksq, occ) & (b->p[opp][R] | b->p[opp][Q])) return 0;
+  if (bishop_attacks(ksq, occ) & (b->p[opp][BISHOP] | b->p[opp][Q])) return 0;
+  if (knight_att[ksq] & b->p[opp][N]) return 0;
+  if (inv_pawn_att[opp][ksq] & b->p[opp][P] & ~(1ULL << capsq)) return 0;
+  return 1;
+}
+
+void gen_legal(const Board *b, MoveList *ml, int type) {
+  ml->n = 0;
+  int stm = b->side, opp = stm ^ 1;
+  int ksq = b->king_sq[stm];
+  if (ksq < 0 || ksq > 63) return;
+  U64 us = b->occ[stm], them = b->occ[opp];
+  U64 occ = us | them;
+  U64 checkers = attackers_of(b, ksq, opp, occ);
+  U64 pinned = board_pinned(b, stm);
+  U64 allow = ~0ULL;
+  if (type == GEN_CAPTURES) allow = them;
+  else if (type == GEN_QUIETS) allow = ~occ;
+  U64 to_bb;
+  int from, to;
+
+  to_bb = king_att[ksq] & ~us & allow;
+  while (to_bb) {
+    to = POP(to_bb);
+    to_bb &= to_bb - 1;
+    if (!attackers_of(b, to, opp, occ ^ (1ULL << ksq))) add_move(ml, MOVE(ksq, to, M_NORMAL));
+  }
+  if (checkers & (checkers - 1)) return;
+
+  U64 target = ~us;
+  if (checkers) target = between_bb[ksq][POP(checkers)] | checkers;
+  U64 promo_rank = stm == W ? 0xFF00000000000000ULL : 0xFFULL;
+
+  U64 p = b->p[stm][P];
+  while (p) {
+    from = POP(p);
+    p &= p - 1;
+    U64 line = (pinned & (1ULL << from)) ? line_bb[ksq][from] : ~0ULL;
+    U64 push = pawn_push[stm][from] & ~occ;
+    if (push && (pawn_push[stm][from] & (pawn_push[stm][from] - 1))) {
+      int one = stm == W ? from + 8 : from - 8;
+      if (occ & (1ULL << one)) push = 0;
+    }
+    push &= target & line;
+    U64 caps = pawn_att[stm][from] & them & target & line;
+    U64 promo = (push | caps) & promo_rank;
+    if (type != GEN_QUIETS) {
+      to_bb = caps & ~promo_rank;
+      while (to_bb) { to = POP(to_bb); to_bb &= to_bb - 1; add_move(ml, MOVE(from, to, M_NORMAL)); }
+      while (promo) { to = POP(promo); promo &= promo - 1; add_promos(ml, from, to); }
+      if (b->ep >= 0 && (pawn_att[stm][from] & (1ULL << b->ep)) && ep_is_legal(b, from, ksq))
+        add_move(ml, MOVE(from, b->ep, M_EP));
+    }
+    if (type != GEN_CAPTURES) {
+      to_bb = push & ~promo_rank;
+      while (to_bb) { to = POP(to_bb); to_bb &= to_bb - 1; add_move(ml, MOVE(from, to, M_NORMAL)); }
+    }
+  }
+
+  for (int pc = N; pc <= Q; pc++) {
+    p = b->p[stm][pc];
+    while (p) {
+      from = POP(p);
+      p &= p - 1;
+      if (pc == N) {
+        if (pinned & (1ULL << from)) continue;
+        to_bb = knight_att[from];
+      } else if (pc == BISHOP) {
+        to_bb = bishop_attacks(from, occ);
+      } else if (pc == R) {
+        to_bb = rook_attacks(from, occ);
+      } else {
+        to_bb = queen_attacks(from, occ);
+      }
+      to_bb &= target & allow;
+      if (pinned & (1ULL << from)) to_bb &= line_bb[ksq][from];
+      while (to_bb) { to = POP(to_bb); to_bb &= to_bb - 1; add_move(ml, MOVE(from, to, M_NORMAL)); }
+    }
+  }
+
+  if (checkers || type == GEN_CAPTURES) return;
+  if ((b->castle & (stm ? 4 : 1)) && (b->p[stm][R] & (1ULL << (stm ? 63 : 7))) &&
+      !(occ & (stm ? 0x6000000000000000ULL : 0x60ULL)) &&
+      !attackers_of(b, stm ? 61 : 5, opp, occ) && !attackers_of(b, stm ? 62 : 6, opp, occ)) {
+    add_move(ml, MOVE(ksq, stm ? 62 : 6, M_CASTLE));
+  }
+  if ((b->castle & (stm ? 8 : 2)) && (b->p[stm][R] & (1ULL << (stm ? 56 : 0))) &&
+      !(occ & (stm ? 0x0E00000000000000ULL : 0x0EULL)) &&
+      !attackers_of(b, stm ? 59 : 3, opp, occ) && !attackers_of(b, stm ? 58 : 2, opp, occ)) {
+    add_move(ml, MOVE(ksq, stm ? 58 : 2, M_CASTLE));
+  }
+}
+
+int move_is_pseudo_legal(const Board *b, Move m) {
+  int from = FROM(m), to = TO(m), fl = FLAGS(m);
+  int stm = b->side, opp = stm ^ 1;
+  int piece = b->piece_on[from];
+  if (PCOLOR(piece) != stm) return 0;
+  int pc = PTYPE(piece);
+  U64 to_bb = 1ULL << to;
+  U64 occ = b->occ[0] | b->occ[1];
+  if (b->occ[stm] & to_bb) return 0;
+  if (fl == M_CASTLE) {
+    if (pc != K || from != (stm ? 60 : 4)) return 0;
+    if (attackers_of(b, from, opp, occ)) return 0;
+    if (to == (stm ? 62 : 6))
+      return (b->castle & (stm ? 4 : 1)) && (b->p[stm][R] & (1ULL << (stm ? 63 : 7))) &&
+             !(occ & (stm ? 0x6000000000000000ULL : 0x60ULL)) &&
+             !attackers_of(b, stm ? 61 : 5, opp, occ) && !attackers_of(b, stm ? 62 : 6, opp, occ);
+    if (to == (stm ? 58 : 2))
+      return (b->castle & (stm ? 8 : 2)) && (b->p[stm][R] & (1ULL << (stm ? 56 : 0))) &&
+             !(occ & (stm ? 0x0E00000000000000ULL : 0x0EULL)) &&
+             !attackers_of(b, stm ? 59 : 3, opp, occ) && !attackers_of(b, stm ? 58 : 2, opp, occ);
+    return 0;
+  }
+  if (pc == P) {
+    int last = RANK(to) == (stm ? 0 : 7);
+    if (fl == M_EP) return to == b->ep && (pawn_att[stm][from] & to_bb);
+    if (last != (fl == M_PROMO)) return 0;
+    if (pawn_att[stm][from] & to_bb & b->occ[opp]) return 1;
+    if (occ & to_bb) return 0;
+    int one = stm == W ? from + 8 : from - 8;
+    if (to == one) return 1;
+    return (pawn_push[stm][from] & to_bb) && !(occ & (1ULL << one));
+  }
+  if (fl != M_NORMAL) return 0;
+  if (pc == N) return (knight_att[from] & to_bb) != 0;
+  if (pc == BISHOP) return (bishop_attacks(from, occ) & to_bb) != 0;
+  if (pc == R) return (rook_attacks(from, occ) & to_bb) != 0;
+  if (pc == Q) return (queen_attacks(from, occ) & to_bb) != 0;
+  return (king_att[from] & to_bb) != 0;
+}
+
+int move_is_legal_fast(const Board *b, Move m, U64 checkers, U64 pinned) {
+  int from = FROM(m), to = TO(m);
+  int stm = b->side;
+  int ksq = b->king_sq[stm];
+  if (ksq < 0 || ksq > 63) return 0;
+  if (from == ksq) {
+    if (FLAGS(m) == M_CASTLE) return !checkers;
+    return !attackers_of(b, to, stm ^ 1, (b->occ[0] | b->occ[1]) ^ (1ULL << ksq));
+  }
+  if (FLAGS(m) == M_EP) return ep_is_legal(b, from, ksq);
+  if (checkers & (checkers - 1)) return 0;
+  if (checkers && !((between_bb[ksq][POP(checkers)] | checkers) & (1ULL << to))) return 0;
+  return !(pinned & (1ULL << from)) || (line_bb[ksq][from] & (1ULL << to));
+}
+
 int move_is_legal(Board *b, Move m) {
   int from = FROM(m), to = TO(m), fl = FLAGS(m);
   int stm = b->side;
   int ksq = b->king_sq[stm];
-  if (ksq < 0 || ksq > 63 || b->piece_on[ksq] != stm * 6 + K) {
+  if (ksq < 0 || ksq > 63 || b->piece_on[ksq] != MAKE_PIECE(stm, K)) {
     U64 kbb = b->p[stm][K];
     ksq = kbb ? POP(kbb) : -1;
     if (ksq < 0) return 0;
   }
   int piece = b->piece_on[from];
-  if (piece < 0 || (piece / 6) != stm) {
+  if (PCOLOR(piece) != stm) {
     int pc;
-    piece = -1;
+    piece = NO_PIECE;
     for (pc = 0; pc < 6; pc++) {
       if ((b->p[stm][pc] >> from) & 1) {
-        piece = stm * 6 + pc;
+        piece = MAKE_PIECE(stm, pc);
         break;
       }
     }
-    if (piece < 0) return 0;
+    if (piece == NO_PIECE) return 0;
   }
-  int pc = piece % 6;
+  int pc = PTYPE(piece);
   if (pc == K) {
     int df = FILE(to) - FILE(from);
     if (df > 1 || df < -1) {
@@ -260,10 +430,10 @@ int move_is_legal(Board *b, Move m) {
   U64 from_bb = 1ULL << from, to_bb = 1ULL << to;
   b->p[stm][pc] ^= from_bb; b->p[stm][pc] |= to_bb;
   b->occ[stm] ^= from_bb; b->occ[stm] |= to_bb;
-  b->piece_on[from] = -1;
+  b->piece_on[from] = NO_PIECE;
   int cap = b->piece_on[to];
-  if (cap >= 0) {
-    int c = cap / 6, p = cap % 6;
+  if (cap != NO_PIECE) {
+    int c = PCOLOR(cap), p = PTYPE(cap);
     b->p[c][p] ^= to_bb;
     b->occ[c] ^= to_bb;
   }
@@ -272,7 +442,7 @@ int move_is_legal(Board *b, Move m) {
     int epsq = stm == W ? to - 8 : to + 8;
     b->p[stm^1][P] ^= (1ULL << epsq);
     b->occ[stm^1] ^= (1ULL << epsq);
-    b->piece_on[epsq] = -1;
+    b->piece_on[epsq] = NO_PIECE;
   }
   if (fl == M_PROMO) {
     int pr = PROMO_PC(m) + 1;
@@ -294,8 +464,8 @@ int move_is_legal(Board *b, Move m) {
   b->occ[stm] |= from_bb;
   b->piece_on[from] = piece;
   b->piece_on[to] = cap;
-  if (cap >= 0) {
-    int c = cap / 6, p = cap % 6;
+  if (cap != NO_PIECE) {
+    int c = PCOLOR(cap), p = PTYPE(cap);
     b->p[c][p] |= to_bb;
     b->occ[c] |= to_bb;
   }
@@ -303,7 +473,7 @@ int move_is_legal(Board *b, Move m) {
     int epsq = stm == W ? to - 8 : to + 8;
     b->p[stm^1][P] |= (1ULL << epsq);
     b->occ[stm^1] |= (1ULL << epsq);
-    b->piece_on[epsq] = (stm^1) * 6 + P;
+    b->piece_on[epsq] = MAKE_PIECE(stm ^ 1, P);
   }
   return legal;
 }
@@ -312,66 +482,70 @@ int see(const Board *b, Move m) {
   int from = FROM(m), to = TO(m), fl = FLAGS(m);
   int side = b->side;
   int piece = b->piece_on[from];
-  if (piece < 0) return 0;
-  int pc = piece % 6;
-  int cap_pc = -1;
-  if (fl == M_EP) {
-    cap_pc = P;
-  } else {
-    int cap = b->piece_on[to];
-    if (cap >= 0) cap_pc = cap % 6;
-  }
-  if (cap_pc < 0 && fl != M_PROMO) return 0;
+  if (piece == NO_PIECE || fl == M_CASTLE) return 0;
+  int on_sq = PTYPE(piece);
+  int cap = fl == M_EP ? P : PTYPE(b->piece_on[to]);
+  if (cap == N_PIECES && fl != M_PROMO) return 0;
 
   int gain[32];
   int depth = 0;
-  gain[0] = (cap_pc >= 0) ? piece_val[cap_pc] : 0;
-
-  U64 occ = b->occ[0] | b->occ[1];
-  U64 pieces[2][6];
-  for (int c = 0; c < 2; c++) for (int p = 0; p < 6; p++) pieces[c][p] = b->p[c][p];
-
-  pieces[side][pc] &= ~(1ULL << from);
-  occ &= ~(1ULL << from);
-  if (cap_pc >= 0 && fl != M_EP) {
-    pieces[side ^ 1][cap_pc] &= ~(1ULL << to);
-  } else if (fl == M_EP) {
-    int epsq = side == W ? to - 8 : to + 8;
-    pieces[side ^ 1][P] &= ~(1ULL << epsq);
-    occ &= ~(1ULL << epsq);
-  }
-  U64 att[2];
-  att[0] = attackers_to(occ, to, 0, pieces);
-  att[1] = attackers_to(occ, to, 1, pieces);
-
-  side ^= 1;
+  gain[0] = cap < N_PIECES ? piece_val[cap] : 0;
+  if (fl == M_PROMO) {
+    on_sq = PROMO_PC(m) + 1;
+    gain[0] += piece_val[on_sq] - piece_val[P];
+  }
+  U64 occ = (b->occ[0] | b->occ[1]) ^ (1ULL << from);
+  if (fl == M_EP) occ ^= 1ULL << (side == W ? to - 8 : to + 8);
+  U64 att = see_attackers(b, to, occ) & occ;
   for (;;) {
-    U64 attackers = att[side];
-    if (!attackers) break;
-    int from_sq = least_attacker_sq(attackers, side, pieces);
-    if (from_sq < 0) break;
-    int attacker_pc = -1;
-    for (int p = 0; p < 6; p++) {
-      if (pieces[side][p] & (1ULL << from_sq)) { attacker_pc = p; break; }
-    }
-    if (attacker_pc < 0) break;
-    depth++;
-    gain[depth] = piece_val[attacker_pc] - gain[depth - 1];
-    {
-      int a = -gain[depth - 1];
-      int b = gain[depth];
-      int mx = a > b ? a : b;
-      if (mx < 0) break;
-    }
-    pieces[side][attacker_pc] &= ~(1ULL << from_sq);
-    occ &= ~(1ULL << from_sq);
-    att[0] = attackers_to(occ, to, 0, pieces);
-    att[1] = attackers_to(occ, to, 1, pieces);
     side ^= 1;
+    U64 bb;
+    int p = see_least(b, att, side, &bb);
+    if (p < 0) break;
+    if (p == K && (att & b->occ[side ^ 1])) break;
+    depth++;
+    gain[depth] = piece_val[on_sq] - gain[depth - 1];
+    on_sq = p;
+    occ ^= bb;
+    att = (att | see_xrays(b, to, p, occ)) & occ;
   }
   for (int i = depth - 1; i >= 0; i--) {
-    int alt = -gain[i + 1];
-    if (alt > gain[i]) gain[i] = alt;
+    if (-gain[i + 1] < gain[i]) gain[i] = -gain[i + 1];
   }
   return gain[0];
 }
+
+/* True if the exchange started by m wins at least threshold; stops as soon as the result is decided. */
+int see_ge(const Board *b, Move m, int threshold) {
+  int from = FROM(m), to = TO(m), fl = FLAGS(m);
+  int side = b->side;
+  int piece = b->piece_on[from];
+  if (piece == NO_PIECE || fl == M_CASTLE) return threshold <= 0;
+  int on_sq = PTYPE(piece);
+  int cap = fl == M_EP ? P : PTYPE(b->piece_on[to]);
+  int swap = (cap < N_PIECES ? piece_val[cap] : 0) - threshold;
+  if (fl == M_PROMO) {
+    on_sq = PROMO_PC(m) + 1;
+    swap += piece_val[on_sq] - piece_val[P];
+  }
+  if (swap < 0) return 0;
+  swap = piece_val[on_sq] - swap;
+  if (swap <= 0) return 1;
+  U64 occ = (b->occ[0] | b->occ[1]) ^ (1ULL << from);
+  if (fl == M_EP) occ ^= 1ULL << (side == W ? to - 8 : to + 8);
+  U64 att = see_attackers(b, to, occ) & occ;
+  int res = 1;
+  for (;;) {
+    side ^= 1;
+    U64 bb;
+    int p = see_least(b, att, side, &bb);
+    if (p < 0) break;
+    res ^= 1;
+    if (p == K) return (att & b->occ[side ^ 1]) ? res ^ 1 : res;
+    swap = piece_val[p] - swap;
+    if (swap < res) break;
+    occ ^= bb;
+    att = (att | see_xrays(b, to, p, occ)) & occ;
+  }
+  return res;
+}
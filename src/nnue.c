@@ -0,0 +1,339 @@
+#include "nnue.h"
+#include "params.h"
+#include "types.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define NNUE_NO_MMAP 1
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HAVE_NNUE_SIMD 1
+#include <immintrin.h>
+#endif
+
+/* HalfKP: for each perspective, (own king square, non-king piece, square).
+   256 int16 accumulator lanes per perspective, then 512 -> 32 -> 32 -> 1 with
+   int8 weights and clipped-ReLU activations in [0, 127]. */
+#define NNUE_PIECE_SQ 641
+#define NNUE_FEATURES (64 * NNUE_PIECE_SQ)
+#define NNUE_L1 32
+#define NNUE_L2 32
+#define NNUE_SHIFT 6
+#define NNUE_OUT_SCALE 16
+#define NNUE_MAX_WALK 8
+#define NNUE_MAX_DIRTY (3 * NNUE_MAX_WALK)
+
+/* File layout (little-endian): this header, then ft_bias, ft_weight, l1_bias,
+   l1_weight, l2_bias, l2_weight, out_bias, out_weight, each tightly packed. */
+typedef struct {
+  char magic[8];
+  uint32_t half, features, l1, l2;
+  uint32_t reserved[10];
+} NNUEHeader;
+
+typedef struct {
+  const int16_t *ft_bias;   /* [HALF] */
+  const int16_t *ft_weight; /* [FEATURES][HALF] */
+  const int32_t *l1_bias;   /* [L1] */
+  const int8_t *l1_weight;  /* [L1][2 * HALF] */
+  const int32_t *l2_bias;   /* [L2] */
+  const int8_t *l2_weight;  /* [L2][L1] */
+  const int32_t *out_bias;  /* [1] */
+  const int8_t *out_weight; /* [L2] */
+} Net;
+
+typedef struct {
+  void (*update)(int16_t *dst, const int16_t *src, const int *add, int na, const int *sub, int ns);
+  void (*affine)(const uint8_t *in, int n_in, const int8_t *w, const int32_t *bias, int32_t *out, int n_out);
+} Kernels;
+
+static Net net;
+static int net_loaded;
+static int kernel_kind = NNUE_KERNEL_SCALAR;
+static Kernels kern;
+
+static void update_scalar(int16_t *dst, const int16_t *src, const int *add, int na, const int *sub, int ns) {
+  if (dst != src) memcpy(dst, src, NNUE_HALF * sizeof(int16_t));
+  for (int j = 0; j < na; j++) {
+    const int16_t *w = net.ft_weight + (size_t)add[j] * NNUE_HALF;
+    for (int i = 0; i < NNUE_HALF; i++) dst[i] += w[i];
+  }
+  for (int j = 0; j < ns; j++) {
+    const int16_t *w = net.ft_weight + (size_t)sub[j] * NNUE_HALF;
+    for (int i = 0; i < NNUE_HALF; i++) dst[i] -= w[i];
+  }
+}
+
+static void affine_scalar(const uint8_t *in, int n_in, const int8_t *w, const int32_t *bias, int32_t *out, int n_out) {
+  for (int o = 0; o < n_out; o++) {
+    const int8_t *row = w + o * n_in;
+    int32_t sum = bias[o];
+    for (int i = 0; i < n_in; i++) sum += (int32_t)in[i] * row[i];
+    out[o] = sum;
+  }
+}
+
+#ifdef HAVE_NNUE_SIMD
+__attribute__((target("sse4.1"))) static void update_sse41(int16_t *dst, const int16_t *src, const int *add, int na, const int *sub, int ns) {
+  for (int i = 0; i < NNUE_HALF; i += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+    for (int j = 0; j < na; j++) v = _mm_add_epi16(v, _mm_loadu_si128((const __m128i *)(net.ft_weight + (size_t)add[j] * NNUE_HALF + i)));
+    for (int j = 0; j < ns; j++) v = _mm_sub_epi16(v, _mm_loadu_si128((const __m128i *)(net.ft_weight + (size_t)sub[j] * NNUE_HALF + i)));
+    _mm_store_si128((__m128i *)(dst + i), v);
+  }
+}
+
+__attribute__((target("sse4.1"))) static void affine_sse41(const uint8_t *in, int n_in, const int8_t *w, const int32_t *bias, int32_t *out, int n_out) {
+  const __m128i ones = _mm_set1_epi16(1);
+  for (int o = 0; o < n_out; o++) {
+    const int8_t *row = w + o * n_in;
+    __m128i sum = _mm_setzero_si128();
+    for (int i = 0; i < n_in; i += 16) {
+      __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+      __m128i y = _mm_loadu_si128((const __m128i *)(row + i));
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(x, y), ones));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    out[o] = bias[o] + _mm_cvtsi128_si32(sum);
+  }
+}
+
+__attribute__((target("avx2"))) static void update_avx2(int16_t *dst, const int16_t *src, const int *add, int na, const int *sub, int ns) {
+  for (int i = 0; i < NNUE_HALF; i += 16) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+    for (int j = 0; j < na; j++) v = _mm256_add_epi16(v, _mm256_loadu_si256((const __m256i *)(net.ft_weight + (size_t)add[j] * NNUE_HALF + i)));
+    for (int j = 0; j < ns; j++) v = _mm256_sub_epi16(v, _mm256_loadu_si256((const __m256i *)(net.ft_weight + (size_t)sub[j] * NNUE_HALF + i)));
+    _mm256_store_si256((__m256i *)(dst + i), v);
+  }
+}
+
+__attribute__((target("avx2"))) static void affine_avx2(const uint8_t *in, int n_in, const int8_t *w, const int32_t *bias, int32_t *out, int n_out) {
+  const __m256i ones = _mm256_set1_epi16(1);
+  for (int o = 0; o < n_out; o++) {
+    const int8_t *row = w + o * n_in;
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < n_in; i += 32) {
+      __m256i x = _mm256_loadu_si256((const __m256i *)(in + i));
+      __m256i y = _mm256_loadu_si256((const __m256i *)(row + i));
+      sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(x, y), ones));
+    }
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    out[o] = bias[o] + _mm_cvtsi128_si32(s);
+  }
+}
+#endif
+
+static int cpu_kernel(void) {
+#ifdef HAVE_NNUE_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return NNUE_KERNEL_AVX2;
+  if (__builtin_cpu_supports("sse4.1")) return NNUE_KERNEL_SSE41;
+#endif
+  return NNUE_KERNEL_SCALAR;
+}
+
+static void pick_kernel(const char *name) {
+  int best = cpu_kernel();
+  if (!name || !*name) name = getenv("NNUE_SIMD");
+  kernel_kind = best;
+  if (name && *name) {
+    if (strcmp(name, "scalar") == 0) kernel_kind = NNUE_KERNEL_SCALAR;
+    else if (strcmp(name, "sse41") == 0 && best >= NNUE_KERNEL_SSE41) kernel_kind = NNUE_KERNEL_SSE41;
+    else if (strcmp(name, "avx2") == 0 && best >= NNUE_KERNEL_AVX2) kernel_kind = NNUE_KERNEL_AVX2;
+  }
+  kern.update = update_scalar;
+  kern.affine = affine_scalar;
+#ifdef HAVE_NNUE_SIMD
+  if (kernel_kind == NNUE_KERNEL_SSE41) { kern.update = update_sse41; kern.affine = affine_sse41; }
+  if (kernel_kind == NNUE_KERNEL_AVX2) { kern.update = update_avx2; kern.affine = affine_avx2; }
+#endif
+}
+
+const char *nnue_kernel_name(void) {
+  if (kernel_kind == NNUE_KERNEL_AVX2) return "avx2";
+  if (kernel_kind == NNUE_KERNEL_SSE41) return "sse41";
+  return "scalar";
+}
+
+int nnue_active(void) { return net_loaded; }
+
+static size_t net_size(void) {
+  return sizeof(NNUEHeader) + NNUE_HALF * 2 + (size_t)NNUE_FEATURES * NNUE_HALF * 2 + NNUE_L1 * 4 +
+         NNUE_L1 * 2 * NNUE_HALF + NNUE_L2 * 4 + NNUE_L2 * NNUE_L1 + 4 + NNUE_L2;
+}
+
+static void unmap_file(const unsigned char *p, size_t len) {
+#ifdef NNUE_NO_MMAP
+  (void)len;
+  free((void *)p);
+#else
+  munmap((void *)p, len);
+#endif
+}
+
+static const unsigned char *map_file(const char *path, size_t *len) {
+#ifdef NNUE_NO_MMAP
+  FILE *f = fopen(path, "rb");
+  if (!f) return NULL;
+  fseek(f, 0, SEEK_END);
+  long n = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  unsigned char *buf = n > 0 ? malloc((size_t)n) : NULL;
+  if (buf && fread(buf, 1, (size_t)n, f) != (size_t)n) { free(buf); buf = NULL; }
+  fclose(f);
+  *len = buf ? (size_t)n : 0;
+  return buf;
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return NULL;
+  struct stat st;
+  void *p = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return NULL;
+  *len = (size_t)st.st_size;
+  return p;
+#endif
+}
+
+int nnue_init(const char *path, const char *kernel) {
+  size_t len = 0;
+  const unsigned char *p = map_file(path, &len);
+  if (!p) return 0;
+  NNUEHeader h;
+  if (len != net_size()) { unmap_file(p, len); return 0; }
+  memcpy(&h, p, sizeof h);
+  if (memcmp(h.magic, "NNUEv1", 6) != 0 || h.half != NNUE_HALF || h.features != NNUE_FEATURES ||
+      h.l1 != NNUE_L1 || h.l2 != NNUE_L2) {
+    unmap_file(p, len);
+    return 0;
+  }
+  p += sizeof h;
+  net.ft_bias = (const int16_t *)p;    p += NNUE_HALF * 2;
+  net.ft_weight = (const int16_t *)p;  p += (size_t)NNUE_FEATURES * NNUE_HALF * 2;
+  net.l1_bias = (const int32_t *)p;    p += NNUE_L1 * 4;
+  net.l1_weight = (const int8_t *)p;   p += NNUE_L1 * 2 * NNUE_HALF;
+  net.l2_bias = (const int32_t *)p;    p += NNUE_L2 * 4;
+  net.l2_weight = (const int8_t *)p;   p += NNUE_L2 * NNUE_L1;
+  net.out_bias = (const int32_t *)p;   p += 4;
+  net.out_weight = (const int8_t *)p;
+  pick_kernel(kernel);
+  net_loaded = 1;
+  return 1;
+}
+
+static inline int feature(int persp, int ksq, int pc, int sq) {
+  if (persp == B) { ksq ^= 56; sq ^= 56; }
+  return ksq * NNUE_PIECE_SQ + 1 + (PTYPE(pc) * 2 + (PCOLOR(pc) != persp)) * 64 + sq;
+}
+
+static void refresh(const Board *b, int persp, int16_t *dst) {
+  int add[32], n = 0;
+  int ksq = b->king_sq[persp];
+  U64 occ = (b->occ[W] | b->occ[B]) & ~(b->p[W][K] | b->p[B][K]);
+  while (occ && n < 32) {
+    int sq = POP(occ);
+    occ &= occ - 1;
+    add[n++] = feature(persp, ksq, b->piece_on[sq], sq);
+  }
+  kern.update(dst, net.ft_bias, add, n, NULL, 0);
+}
+
+/* Feature changes of the move recorded in h, seen from persp with its king on ksq. */
+static void dirty_features(const Hist *h, int persp, int ksq, int *add, int *na, int *sub, int *ns) {
+  Move m = h->move;
+  int from = FROM(m), to = TO(m), fl = FLAGS(m);
+  int pc = h->piece, c = PCOLOR(pc);
+  if (PTYPE(pc) != K) {
+    sub[(*ns)++] = feature(persp, ksq, pc, from);
+    add[(*na)++] = feature(persp, ksq, fl == M_PROMO ? MAKE_PIECE(c, PROMO_PC(m) + 1) : pc, to);
+  } else if (fl == M_CASTLE) {
+    int rfrom = (to == 6 || to == 62) ? (to + 1) : (to - 2);
+    int rto = (to == 6 || to == 62) ? (to - 1) : (to + 1);
+    sub[(*ns)++] = feature(persp, ksq, MAKE_PIECE(c, R), rfrom);
+    add[(*na)++] = feature(persp, ksq, MAKE_PIECE(c, R), rto);
+  }
+  if (h->cap != NO_PIECE) sub[(*ns)++] = feature(persp, ksq, h->cap, to);
+  else if (fl == M_EP) sub[(*ns)++] = feature(persp, ksq, MAKE_PIECE(c ^ 1, P), c == W ? to - 8 : to + 8);
+}
+
+#define ACC_SLOT(ply) ((ply) % NNUE_ACC_PLIES)
+
+static void accumulate(const Position *pos, const Board *b, Accumulator *a) {
+  int h = pos->hply, k = h - 1;
+  while (k >= 0 && k >= h - NNUE_MAX_WALK && pos->acc_key[ACC_SLOT(k)] != pos->hist[k].key) k--;
+  if (k < 0 || k < h - NNUE_MAX_WALK) {
+    refresh(b, W, a->v[W]);
+    refresh(b, B, a->v[B]);
+    return;
+  }
+  for (int persp = 0; persp < 2; persp++) {
+    int add[NNUE_MAX_DIRTY], sub[NNUE_MAX_DIRTY], na = 0, ns = 0, king_moved = 0;
+    for (int i = k; i < h && !king_moved; i++) {
+      if (pos->hist[i].piece == MAKE_PIECE(persp, K)) king_moved = 1;
+      else dirty_features(&pos->hist[i], persp, b->king_sq[persp], add, &na, sub, &ns);
+    }
+    if (king_moved) refresh(b, persp, a->v[persp]);
+    else kern.update(a->v[persp], pos->acc[ACC_SLOT(k)].v[persp], add, na, sub, ns);
+  }
+}
+
+static int propagate(const int16_t *us, const int16_t *them) {
+  _Alignas(32) uint8_t in[2 * NNUE_HALF];
+  _Alignas(32) uint8_t h1[NNUE_L1], h2[NNUE_L2];
+  int32_t o1[NNUE_L1], o2[NNUE_L2], out;
+  for (int i = 0; i < NNUE_HALF; i++) {
+    in[i] = (uint8_t)(us[i] < 0 ? 0 : us[i] > 127 ? 127 : us[i]);
+    in[NNUE_HALF + i] = (uint8_t)(them[i] < 0 ? 0 : them[i] > 127 ? 127 : them[i]);
+  }
+  kern.affine(in, 2 * NNUE_HALF, net.l1_weight, net.l1_bias, o1, NNUE_L1);
+  for (int i = 0; i < NNUE_L1; i++) { int v = o1[i] >> NNUE_SHIFT; h1[i] = (uint8_t)(v < 0 ? 0 : v > 127 ? 127 : v); }
+  kern.affine(h1, NNUE_L1, net.l2_weight, net.l2_bias, o2, NNUE_L2);
+  for (int i = 0; i < NNUE_L2; i++) { int v = o2[i] >> NNUE_SHIFT; h2[i] = (uint8_t)(v < 0 ? 0 : v > 127 ? 127 : v); }
+  kern.affine(h2, NNUE_L2, net.out_weight, net.out_bias, &out, 1);
+  out /= NNUE_OUT_SCALE;
+  /* Keep the score out of the band search and the TT read as mate-in-n. */
+  int lim = MATE - PARAM_MATE_SCORE_WINDOW - 1;
+  return out < -lim ? -lim : out > lim ? lim : out;
+}
+
+/* Side-to-move score, clamped below mate scores; the accumulator is brought
+   up to date from the nearest computed ancestor ply, or rebuilt when none is
+   close enough. */
+int nnue_evaluate(Position *pos, const Board *b) {
+  int slot = ACC_SLOT(pos->hply);
+  Accumulator *a = &pos->acc[slot];
+  if (pos->acc_key[slot] != b->key) {
+    accumulate(pos, b, a);
+    pos->acc_key[slot] = b->key;
+  }
+  return propagate(a->v[b->side], a->v[b->side ^ 1]);
+}
+
+int nnue_evaluate_full(const Board *b) {
+  Accumulator a;
+  refresh(b, W, a.v[W]);
+  refresh(b, B, a.v[B]);
+  return propagate(a.v[b->side], a.v[b->side ^ 1]);
+}
+
+int nnue_verify(Position *pos) {
+  Accumulator a;
+  int score = nnue_evaluate(pos, &pos->b);
+  const Accumulator *inc = &pos->acc[ACC_SLOT(pos->hply)];
+  refresh(&pos->b, W, a.v[W]);
+  refresh(&pos->b, B, a.v[B]);
+  return memcmp(a.v, inc->v, sizeof a.v) == 0 && score == nnue_evaluate_full(&pos->b);
+}
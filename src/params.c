@@ -1,85 +1,46 @@
 #include "params.h"
 
-const int PARAM_QMAX = 32;
-const int PARAM_NULL_DEPTH = 2;
-const int PARAM_LMR_DEPTH = 4;
-const int PARAM_LMR_MOVES = 4;
-const int PARAM_ASPIRATION_DELTA = 60;
-const int PARAM_ASPIRATION_GROW = 30;
-const int PARAM_MATE_WINDOW_MARGIN = 500;
-const int PARAM_MATE_SCORE_CUTOFF = 64;
-const int PARAM_HASH_MOVE_SCORE = 30000;
-const int PARAM_HASH_MOVE_TOP_SCORE = 20000;
-const int PARAM_CHECK_BONUS = 2000;
-const int PARAM_PROMO_BASE_SCORE = 25000;
-const int PARAM_PROMO_CAPTURE_BONUS = 8000;
-const int PARAM_CAPTURE_BASE_SCORE = 10000;
-const int PARAM_CAPTURE_MVV_LVA_FACTOR = 10;
-const int PARAM_SEE_GOOD_BONUS = 500;
-const int PARAM_SEE_BAD_PENALTY = 1500;
-const int PARAM_KILLER_SCORE_1 = 9000;
-const int PARAM_KILLER_SCORE_2 = 8000;
-const int PARAM_HISTORY_MAX = 2000000;
-const int PARAM_TIME_CHECK_INTERVAL = 1024;
-const int PARAM_NULL_REDUCTION = 1;
-const int PARAM_LMR_REDUCTION = 2;
-const int PARAM_MATE_SCORE_WINDOW = 1000;
-const int PARAM_RAZOR_MARGIN = 350;
-const int PARAM_FUTILITY_MARGIN = 120;
-const int PARAM_LMP_DEPTH = 2;
-const int PARAM_LMP_MOVES = 8;
-const int PARAM_FIFTY_MOVE_LIMIT = 100;
+#include <stdio.h>
+#include <string.h>
 
-const int PARAM_PHASE_MAX = 24;
-const int PARAM_PHASE_PAWN = 0;
-const int PARAM_PHASE_KNIGHT = 1;
-const int PARAM_PHASE_BISHOP = 1;
-const int PARAM_PHASE_ROOK = 2;
-const int PARAM_PHASE_QUEEN = 4;
+#ifdef TUNABLE
+#define PARAM_DEFINE(name, v) int name = (v);
+PARAM_LIST(PARAM_DEFINE)
 
-const int PARAM_VAL_PAWN = 100;
-const int PARAM_VAL_KNIGHT = 320;
-const int PARAM_VAL_BISHOP = 330;
-const int PARAM_VAL_ROOK = 500;
-const int PARAM_VAL_QUEEN = 900;
-const int PARAM_VAL_KING = 0;
+typedef struct {
+  const char *name;
+  int *v;
+} ParamEntry;
 
-const int PARAM_PAWN_DOUBLED_PENALTY = 24;
-const int PARAM_PAWN_ISOLATED_PENALTY = 12;
-const int PARAM_PASSED_PAWN_BASE = 20;
-const int PARAM_PASSED_PAWN_ADVANCE = 12;
-const int PARAM_KING_SHIELD_RANK1 = 18;
-const int PARAM_KING_SHIELD_RANK2 = 10;
-const int PARAM_KING_OPEN_FILE_PENALTY = 30;
-const int PARAM_KING_BACK_RANK_PENALTY = 12;
-const int PARAM_ROOK_OPEN_FILE_BONUS = 22;
-const int PARAM_ROOK_SEMI_OPEN_BONUS = 14;
-const int PARAM_ROOK_SEVENTH_BONUS = 14;
-const int PARAM_PAWN_STRUCTURE_WEIGHT = 1;
-const int PARAM_KING_SAFETY_WEIGHT = 3;
-const int PARAM_ROOK_ACTIVITY_WEIGHT = 2;
-const int PARAM_BISHOP_PAIR_BONUS = 35;
-const int PARAM_KING_ATTACK_SCALE = 8;
-const int PARAM_ATTACK_WEIGHT_PAWN = 3;
-const int PARAM_ATTACK_WEIGHT_MINOR = 4;
-const int PARAM_ATTACK_WEIGHT_ROOK = 6;
-const int PARAM_ATTACK_WEIGHT_QUEEN = 8;
-const int PARAM_HANGING_PENALTY_PCT = 80;
-const int PARAM_TEMPO_BONUS = 15;
-const int PARAM_MOBILITY_WEIGHT = 7;
-const int PARAM_CENTER_OCC_BONUS = 12;
-const int PARAM_CENTER_EXT_BONUS = 6;
-const int PARAM_CONTEMPT = 20;
-const int PARAM_TT_HIT_MIN_DEPTH = 2;
-const int PARAM_TT_HIT_TIME_MS = 1500;
-const int PARAM_TT_HIT_TIME_PCT = 40;
-const int PARAM_TT_INSTANT_HIT = 1;
-const int PARAM_PV_STABLE_DELTA = 20;
-const int PARAM_PV_STABLE_MIN_DEPTH = 3;
-const int PARAM_DEFAULT_SEARCH_DEPTH = 52;
-const int PARAM_DEFAULT_MOVE_TIME_MS = 10000;
-const int PARAM_MOVE_TIME_INCREMENT_MS = 0;
-const int PARAM_TT_CLEAR_ON_NEW_SEARCH = 0;
-const int PARAM_TT_LOAD_ON_START = 1;
-const int PARAM_TT_SAVE_ON_EXIT = 1;
-const char *PARAM_TT_CACHE_PATH = "tt_cache.bin";
+#define PARAM_ENTRY(name, v) { #name, &name },
+static const ParamEntry param_table[] = { PARAM_LIST(PARAM_ENTRY) };
+
+/* Accepts the full name or the name without its PARAM_ prefix. */
+int params_set(const char *name, int value) {
+  for (size_t i = 0; i < sizeof(param_table) / sizeof(param_table[0]); i++) {
+    if (strcmp(param_table[i].name, name) && strcmp(param_table[i].name + 6, name)) continue;
+    *param_table[i].v = value;
+    return 1;
+  }
+  return 0;
+}
+#else
+int params_set(const char *name, int value) {
+  (void)name;
+  (void)value;
+  return 0;
+}
+#endif
+
+int params_load(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) return -1;
+  char line[256], name[128];
+  int value, n = 0;
+  while (fgets(line, sizeof line, f)) {
+    if (line[0] == '#' || sscanf(line, "%127s %d", name, &value) != 2) continue;
+    n += params_set(name, value);
+  }
+  fclose(f);
+  return n;
+}
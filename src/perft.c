@@ -0,0 +1,127 @@
+#include "perft.h"
+#include "board.h"
+#include "movegen.h"
+#include "uci.h"
+#include "types.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define PERFT_MAX_THREADS 64
+
+/* Lockless entries: key is stored xor'd with data, so a torn write never verifies. */
+typedef struct { U64 key; U64 data; } PerftEntry;
+
+static PerftEntry *perft_tab;
+static U64 perft_mask;
+
+static void perft_hash_init(void) {
+  const char *env = getenv("PERFT_HASH_MB");
+  U64 mb = (env && *env) ? (U64)atoi(env) : 0;
+  free(perft_tab);
+  perft_tab = NULL;
+  if (!mb) return;
+  U64 n = 1;
+  while (n * 2 * sizeof(PerftEntry) <= mb << 20) n *= 2;
+  perft_tab = calloc(n, sizeof(PerftEntry));
+  perft_mask = perft_tab ? n - 1 : 0;
+}
+
+static U64 perft_rec(Position *pos, int depth) {
+  MoveList ml;
+  gen_legal(&pos->b, &ml, GEN_ALL);
+  if (depth == 1) return (U64)ml.n;
+  U64 key = pos->b.key;
+  PerftEntry *e = perft_tab ? &perft_tab[key & perft_mask] : NULL;
+  if (e) {
+    U64 d = e->data;
+    if ((e->key ^ d) == key && (int)(d & 0xFF) == depth) return d >> 8;
+  }
+  U64 n = 0;
+  for (int i = 0; i < ml.n; i++) {
+    if (!make_move(pos, ml.m[i])) continue;
+    n += perft_rec(pos, depth - 1);
+    unmake_move(pos, ml.m[i]);
+  }
+  if (e) {
+    U64 d = (n << 8) | (U64)depth;
+    e->key = key ^ d;
+    e->data = d;
+  }
+  return n;
+}
+
+U64 perft(Position *pos, int depth) {
+  if (depth <= 0) return 1;
+  return perft_rec(pos, depth);
+}
+
+typedef struct {
+  const Position *root;
+  const MoveList *ml;
+  U64 *counts;
+  int depth;
+  int next;
+} PerftJob;
+
+static void *perft_worker(void *arg) {
+  PerftJob *job = arg;
+  Position *pos = aligned_alloc(_Alignof(Position), sizeof(Position));
+  if (!pos) return NULL;
+  *pos = *job->root;
+  for (;;) {
+    int i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+    if (i >= job->ml->n) break;
+    Move m = job->ml->m[i];
+    if (!make_move(pos, m)) continue;
+    job->counts[i] = perft(pos, job->depth - 1);
+    unmake_move(pos, m);
+  }
+  free(pos);
+  return NULL;
+}
+
+static long long wall_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+U64 perft_run(const Position *pos, int depth, int divide) {
+  const char *env = getenv("PERFT_THREADS");
+  int threads = (env && *env) ? atoi(env) : 1;
+  if (threads < 1) threads = 1;
+  if (threads > PERFT_MAX_THREADS) threads = PERFT_MAX_THREADS;
+  perft_hash_init();
+  long long start = wall_ms();
+  MoveList ml;
+  gen_legal(&pos->b, &ml, GEN_ALL);
+  U64 counts[MAX_MOVES] = {0};
+  U64 total = 0;
+  if (depth <= 0) {
+    total = 1;
+  } else if (depth == 1) {
+    for (int i = 0; i < ml.n; i++) counts[i] = 1;
+    total = (U64)ml.n;
+  } else {
+    PerftJob job = { pos, &ml, counts, depth, 0 };
+    pthread_t tid[PERFT_MAX_THREADS];
+    int started = 0;
+    for (int t = 1; t < threads; t++) {
+      if (pthread_create(&tid[started], NULL, perft_worker, &job) == 0) started++;
+    }
+    perft_worker(&job);
+    for (int t = 0; t < started; t++) pthread_join(tid[t], NULL);
+    for (int i = 0; i < ml.n; i++) total += counts[i];
+  }
+  long long ms = wall_ms() - start;
+  if (divide && depth > 0) {
+    for (int i = 0; i < ml.n; i++) printf("%s: %llu\n", move_to_uci(ml.m[i]), (unsigned long long)counts[i]);
+    printf("\n");
+  }
+  long long nps = ms > 0 ? (long long)(total * 1000 / (U64)ms) : 0;
+  printf("%llu %lldms d=%d nps=%lld\n", (unsigned long long)total, ms, depth, nps);
+  return total;
+}
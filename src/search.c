@@ -1,5 +1,7 @@
 #include "search.h"
+#include "bitbase.h"
 #include "board.h"
+#include "endgame.h"
 #include "eval.h"
 #include "movegen.h"
 #include "params.h"
@@ -25,10 +27,12 @@ static int search_exclude_active;
 static Move search_exclude_move;
 static U64 search_exclude_key;
 static int search_exclude_ply;
+static int search_root_hply;
 
 typedef struct {
   int ep;
   int ply;
+  int since_null;
   U64 key;
 } NullState;
 
@@ -41,7 +45,7 @@ static inline int promo_piece(Move m) {
 }
 
 static inline int is_capture(const Board *b, Move m) {
-  return (b->piece_on[TO(m)] >= 0) || (FLAGS(m) == M_EP);
+  return (b->piece_on[TO(m)] != NO_PIECE) || (FLAGS(m) == M_EP);
 }
 
 static inline int clamp_ply(int ply) {
@@ -65,9 +69,11 @@ static inline int score_from_tt(int score, int ply) {
 static inline void make_null(Board *b, NullState *st) {
   st->ep = b->ep;
   st->ply = b->ply;
+  st->since_null = b->since_null;
   st->key = b->key;
   b->key = tables_key_after_null(b);
   b->ep = -1;
+  b->since_null = 0;
   b->side ^= 1;
   b->ply++;
 }
@@ -76,9 +82,37 @@ static inline void unmake_null(Board *b, const NullState *st) {
   b->side ^= 1;
   b->ep = st->ep;
   b->ply = st->ply;
+  b->since_null = st->since_null;
   b->key = st->key;
 }
 
+/* Makes m from b and returns the child board, or NULL if m is illegal. The
+   history entry is pushed either way, for repetitions and NNUE updates.
+   COPY_MAKE builds make m on a copy of b in pos->copy[hply + 1], so the
+   parent is never modified and needs no unmake. */
+static inline Board *do_move(Position *pos, Board *b, Move m) {
+#ifdef COPY_MAKE
+  if (pos->hply >= HIST_SIZE) return NULL;
+  Board *c = &pos->copy[pos->hply + 1];
+  *c = *b;
+  if (!board_make(c, m, &pos->hist[pos->hply])) return NULL;
+  pos->hply++;
+  return c;
+#else
+  (void)b;
+  return make_move(pos, m) ? &pos->b : NULL;
+#endif
+}
+
+static inline void undo_move(Position *pos, Move m) {
+#ifdef COPY_MAKE
+  (void)m;
+  board_pop_hist(pos);
+#else
+  unmake_move(pos, m);
+#endif
+}
+
 static inline void clear_search_heuristics(void) {
   memset(killer_moves, 0, sizeof(killer_moves));
   memset(history_heur, 0, sizeof(history_heur));
@@ -107,7 +141,7 @@ static inline int in_check_now(const Board *b) {
 }
 
 static inline int has_non_pawn_material(const Board *b, int side) {
-  return (b->p[side][N] | b->p[side][BISHOP] | b->p[side][R] | b->p[side][Q]) != 0;
+  return b->non_pawn[side] != 0;
 }
 
 static inline int should_try_null(const Board *b, int depth, int in_check) {
@@ -154,11 +188,11 @@ static inline void note_beta_cutoff(const Board *b, Move m, int depth) {
 static int move_score_capture(const Board *b, Move m) {
   int to = TO(m), from = FROM(m), fl = FLAGS(m);
   int cap = b->piece_on[to];
-  int victim = (cap >= 0) ? (cap % 6) : (fl == M_EP ? P : -1);
+  int victim = (cap != NO_PIECE) ? PTYPE(cap) : (fl == M_EP ? P : -1);
   int piece = b->piece_on[from];
   int score = 0;
-  if (victim >= 0 && piece >= 0) {
-    int pc = piece % 6;
+  if (victim >= 0 && piece != NO_PIECE) {
+    int pc = PTYPE(piece);
     score = PARAM_CAPTURE_BASE_SCORE + piece_val[victim] * PARAM_CAPTURE_MVV_LVA_FACTOR - piece_val[pc];
   }
   if (fl == M_PROMO) score += PARAM_PROMO_CAPTURE_BONUS + piece_val[promo_piece(m)];
@@ -180,23 +214,62 @@ static void sort_captures(Board *b, MoveList *ml) {
   }
 }
 
-static int quiesce(Board *b, int alpha, int beta, int qply) {
+/* Inside a won ending the tables only say "win"; this steers towards the
+   conversion: the losing king to the edge (to the bishop's corners with a
+   bishop), the winning king closer, pawns forward. */
+static int bitbase_progress(const Board *b, int winner) {
+  int wk = b->king_sq[winner], lk = b->king_sq[winner ^ 1];
+  int f = FILE(lk), r = RANK(lk);
+  int s = ((f < 4 ? 3 - f : f - 4) + (r < 4 ? 3 - r : r - 4)) * 10;
+  s += (14 - abs(FILE(wk) - f) - abs(RANK(wk) - r)) * 4;
+  if (b->p[winner][BISHOP]) {
+    int bsq = POP(b->p[winner][BISHOP]);
+    int c1 = (FILE(bsq) + RANK(bsq)) & 1 ? SQ(0, 7) : SQ(0, 0);
+    int c2 = c1 ^ 63;
+    int d1 = abs(FILE(c1) - f) > abs(RANK(c1) - r) ? abs(FILE(c1) - f) : abs(RANK(c1) - r);
+    int d2 = abs(FILE(c2) - f) > abs(RANK(c2) - r) ? abs(FILE(c2) - f) : abs(RANK(c2) - r);
+    s += (7 - (d1 < d2 ? d1 : d2)) * 12;
+  }
+  U64 pawns = b->p[winner][P];
+  while (pawns) {
+    int sq = POP(pawns);
+    pawns &= pawns - 1;
+    s += (winner == W ? RANK(sq) : 7 - RANK(sq)) * 8;
+  }
+  return s;
+}
+
+/* Bitbase verdict below the root, or INF without one. Draws always hold;
+   wins and losses only while the fifty-move counter leaves room for the
+   table's longest win, and not in check, where the search finds the mate. */
+static int bitbase_score(const Position *pos, const Board *b, int in_check) {
+  if (pos->hply <= search_root_hply) return INF;
+  int plies = 0, v = bitbase_probe(b, &plies);
+  if (v == BB_DRAW) return b->side == W ? PARAM_CONTEMPT : -PARAM_CONTEMPT;
+  if (v == BB_UNKNOWN || in_check || b->fifty + plies >= PARAM_FIFTY_MOVE_LIMIT) return INF;
+  int dist = pos->hply - search_root_hply;
+  if (v == BB_WIN) return BITBASE_WIN_SCORE + bitbase_progress(b, b->side) - dist;
+  return -BITBASE_WIN_SCORE - bitbase_progress(b, b->side ^ 1) + dist;
+}
+
+static int quiesce(Position *pos, Board *b, int alpha, int beta, int qply) {
   search_nodes++;
   search_check_time();
-  if (search_abort) return eval(b);
-  int stand = eval(b);
+  if (search_abort) return evaluate(pos, b);
+  int in_check = in_check_now(b);
+  int bb_score = bitbase_score(pos, b, in_check);
+  if (bb_score != INF) return bb_score;
+  int stand = evaluate(pos, b);
   if (stand >= beta) return beta;
   if (stand > alpha) alpha = stand;
   if (qply >= PARAM_QMAX) return stand;
-  int in_check = in_check_now(b);
   MoveList ml;
-  gen_moves(b, &ml);
+  gen_legal(b, &ml, in_check ? GEN_ALL : GEN_CAPTURES);
   if (!in_check) {
     int j = 0;
     for (int i = 0; i < ml.n; i++) {
       Move m = ml.m[i];
-      if (!is_capture(b, m) && FLAGS(m) != M_PROMO) continue;
-      if (see(b, m) < 0) continue;
+      if (!see_ge(b, m, 0)) continue;
       ml.m[j++] = m;
     }
     ml.n = j;
@@ -206,10 +279,10 @@ static int quiesce(Board *b, int alpha, int beta, int qply) {
   for (int i = 0; i < ml.n; i++) {
     Move m = ml.m[i];
     if (is_root_excluded(b, m)) continue;
-    if (!move_is_legal(b, m)) continue;
-    if (!make_move(b, m)) continue;
-    int score = -quiesce(b, -beta, -alpha, qply + 1);
-    unmake_move(b, m);
+    Board *c = do_move(pos, b, m);
+    if (!c) continue;
+    int score = -quiesce(pos, c, -beta, -alpha, qply + 1);
+    undo_move(pos, m);
     if (score >= beta) return beta;
     if (score > alpha) alpha = score;
     if (score > best) best = score;
@@ -217,129 +290,222 @@ static int quiesce(Board *b, int alpha, int beta, int qply) {
   return best;
 }
 
-static int move_gives_check(Board *b, Move m) {
-  if (!make_move(b, m)) return 0;
-  int check = in_check_now(b);
-  unmake_move(b, m);
-  return check;
+#define PICK_TT 0
+#define PICK_CAPTURES_INIT 1
+#define PICK_GOOD_CAPTURES 2
+#define PICK_KILLER_1 3
+#define PICK_KILLER_2 4
+#define PICK_COUNTER 5
+#define PICK_QUIETS_INIT 6
+#define PICK_QUIETS 7
+#define PICK_BAD_CAPTURES 8
+#define PICK_DONE 9
+
+/* Staged move picker: each stage generates and scores its moves only when it is reached. */
+typedef struct {
+  Board *b;
+  int stage;
+  Move tt_move;
+  Move killer[2];
+  Move counter;
+  U64 checkers;
+  U64 pinned;
+  const CheckInfo *ci;
+  MoveList ml;
+  int scores[MAX_MOVES];
+  int cur;
+  Move bad[MAX_MOVES];
+  int nbad;
+  int bad_cur;
+} MovePicker;
+
+static inline int move_is_valid(const Board *b, Move m, U64 checkers, U64 pinned) {
+  return m && move_is_pseudo_legal(b, m) && move_is_legal_fast(b, m, checkers, pinned);
 }
 
-static void score_moves(Board *b, MoveList *ml, Move hash_move, Move prev_move, int *scores) {
+static void picker_init(MovePicker *mp, Board *b, Move tt_move, Move prev_move, U64 checkers, U64 pinned,
+                        const CheckInfo *ci) {
   int ply = clamp_ply(b->ply);
-  Move cm = 0;
-  if (prev_move) {
-    cm = counter_move[b->side][FROM(prev_move)][TO(prev_move)];
-  }
-  for (int i = 0; i < ml->n; i++) {
-    Move m = ml->m[i];
-    int score = 0;
-    if (m == hash_move) {
-      score = PARAM_HASH_MOVE_SCORE;
-    } else if (FLAGS(m) == M_PROMO) {
-      int promo = promo_piece(m);
-      score = PARAM_PROMO_BASE_SCORE + piece_val[promo];
-      if (is_capture(b, m)) score += move_score_capture(b, m);
-    } else if (is_capture(b, m)) {
-      int sc = move_score_capture(b, m);
-      int see_score = see(b, m);
-      if (see_score < 0) sc -= PARAM_SEE_BAD_PENALTY;
-      else if (see_score > 0) sc += PARAM_SEE_GOOD_BONUS;
-      score = sc > 0 ? sc : 0;
-    } else if (m == killer_moves[0][ply]) {
-      score = PARAM_KILLER_SCORE_1;
-    } else if (m == killer_moves[1][ply]) {
-      score = PARAM_KILLER_SCORE_2;
-    } else if (cm && m == cm) {
-      score = PARAM_KILLER_SCORE_1 - 500; /* slightly below killer */
-    } else {
-      score = history_heur[b->side][FROM(m)][TO(m)];
-    }
-    if (PARAM_CHECK_BONUS > 0 && move_gives_check(b, m)) score += PARAM_CHECK_BONUS;
-    scores[i] = score;
+  mp->b = b;
+  mp->stage = PICK_TT;
+  mp->checkers = checkers;
+  mp->pinned = pinned;
+  mp->ci = ci;
+  mp->tt_move = move_is_valid(b, tt_move, checkers, pinned) ? tt_move : 0;
+  mp->killer[0] = killer_moves[0][ply];
+  mp->killer[1] = killer_moves[1][ply];
+  mp->counter = prev_move ? counter_move[b->side ^ 1][FROM(prev_move)][TO(prev_move)] : 0;
+  mp->cur = 0;
+  mp->nbad = 0;
+  mp->bad_cur = 0;
+}
+
+static int picker_quiet_ok(const MovePicker *mp, Move m) {
+  if (!m || m == mp->tt_move) return 0;
+  if (is_capture(mp->b, m) || FLAGS(m) == M_PROMO) return 0;
+  return move_is_valid(mp->b, m, mp->checkers, mp->pinned);
+}
+
+static Move picker_take_best(MovePicker *mp) {
+  int best = mp->cur;
+  for (int j = mp->cur + 1; j < mp->ml.n; j++)
+    if (mp->scores[j] > mp->scores[best]) best = j;
+  Move m = mp->ml.m[best];
+  if (best != mp->cur) {
+    mp->ml.m[best] = mp->ml.m[mp->cur];
+    mp->scores[best] = mp->scores[mp->cur];
   }
+  mp->cur++;
+  return m;
 }
 
-static void order_moves(MoveList *ml, int *scores) {
-  int i, j;
-  for (i = 0; i < ml->n - 1; i++) {
-    int best = i;
-    for (j = i + 1; j < ml->n; j++)
-      if (scores[j] > scores[best]) best = j;
-    if (best != i) {
-      Move t = ml->m[i]; ml->m[i] = ml->m[best]; ml->m[best] = t;
-      int st = scores[i]; scores[i] = scores[best]; scores[best] = st;
-    }
+static Move picker_next(MovePicker *mp) {
+  Board *b = mp->b;
+  Move m;
+  switch (mp->stage) {
+    case PICK_TT:
+      mp->stage = PICK_CAPTURES_INIT;
+      if (mp->tt_move) return mp->tt_move;
+      /* fall through */
+    case PICK_CAPTURES_INIT:
+      gen_legal(b, &mp->ml, GEN_CAPTURES);
+      for (int i = 0; i < mp->ml.n; i++) {
+        m = mp->ml.m[i];
+        if (FLAGS(m) == M_PROMO) {
+          mp->scores[i] = PARAM_PROMO_BASE_SCORE + piece_val[promo_piece(m)];
+          if (is_capture(b, m)) mp->scores[i] += move_score_capture(b, m);
+        } else {
+          mp->scores[i] = move_score_capture(b, m);
+        }
+      }
+      mp->cur = 0;
+      mp->stage = PICK_GOOD_CAPTURES;
+      /* fall through */
+    case PICK_GOOD_CAPTURES:
+      while (mp->cur < mp->ml.n) {
+        m = picker_take_best(mp);
+        if (m == mp->tt_move) continue;
+        if (FLAGS(m) != M_PROMO && !see_ge(b, m, 0)) {
+          mp->bad[mp->nbad++] = m;
+          continue;
+        }
+        return m;
+      }
+      mp->stage = PICK_KILLER_1;
+      /* fall through */
+    case PICK_KILLER_1:
+      mp->stage = PICK_KILLER_2;
+      if (picker_quiet_ok(mp, mp->killer[0])) return mp->killer[0];
+      /* fall through */
+    case PICK_KILLER_2:
+      mp->stage = PICK_COUNTER;
+      if (mp->killer[1] != mp->killer[0] && picker_quiet_ok(mp, mp->killer[1])) return mp->killer[1];
+      /* fall through */
+    case PICK_COUNTER:
+      mp->stage = PICK_QUIETS_INIT;
+      if (mp->counter != mp->killer[0] && mp->counter != mp->killer[1] && picker_quiet_ok(mp, mp->counter))
+        return mp->counter;
+      /* fall through */
+    case PICK_QUIETS_INIT:
+      gen_legal(b, &mp->ml, GEN_QUIETS);
+      for (int i = 0; i < mp->ml.n; i++) {
+        m = mp->ml.m[i];
+        mp->scores[i] = history_heur[b->side][FROM(m)][TO(m)];
+        if (PARAM_CHECK_BONUS > 0 && move_gives_check(b, mp->ci, m)) mp->scores[i] += PARAM_CHECK_BONUS;
+      }
+      mp->cur = 0;
+      mp->stage = PICK_QUIETS;
+      /* fall through */
+    case PICK_QUIETS:
+      while (mp->cur < mp->ml.n) {
+        m = picker_take_best(mp);
+        if (m == mp->tt_move || m == mp->killer[0] || m == mp->killer[1] || m == mp->counter) continue;
+        return m;
+      }
+      mp->stage = PICK_BAD_CAPTURES;
+      /* fall through */
+    case PICK_BAD_CAPTURES:
+      if (mp->bad_cur < mp->nbad) return mp->bad[mp->bad_cur++];
+      mp->stage = PICK_DONE;
+      /* fall through */
+    default:
+      return 0;
   }
 }
 
-static int search_inner(Board *b, int depth, int alpha, int beta, Move *pv_best, Move prev_move) {
+static int search_inner(Position *pos, Board *b, int depth, int alpha, int beta, Move *pv_best, Move prev_move) {
   search_nodes++;
   search_check_time();
-  if (search_abort) return eval(b);
+  if (search_abort) return evaluate(pos, b);
   if (b->fifty >= PARAM_FIFTY_MOVE_LIMIT) return (b->side == W ? PARAM_CONTEMPT : -PARAM_CONTEMPT);
-  if (board_is_repetition(b)) return (b->side == W ? PARAM_CONTEMPT : -PARAM_CONTEMPT);
+  int draw = b->side == W ? PARAM_CONTEMPT : -PARAM_CONTEMPT;
+  if (board_is_repetition(pos, b)) return draw;
+  if (alpha < draw && board_upcoming_repetition(pos, b, pos->hply - search_root_hply)) {
+    alpha = draw;
+    if (alpha >= beta) return alpha;
+  }
+  int eg_scale;
+  if (pos->hply > search_root_hply && endgame_probe(b, &eg_scale) == EG_DRAW) return draw;
   int alpha_orig = alpha;
-  int in_check = in_check_now(b);
+  U64 checkers = board_checkers(b);
+  int in_check = checkers != 0;
+  int bb_score = bitbase_score(pos, b, in_check);
+  if (bb_score != INF) return bb_score;
   if (in_check && depth < MAX_DEPTH - 1) depth++;
-  if (depth <= 0) return quiesce(b, alpha, beta, 0);
+  if (depth <= 0) return quiesce(pos, b, alpha, beta, 0);
 
   int static_eval = 0;
-  if (!in_check) {
-    static_eval = eval(b);
+  if (!in_check && depth <= 2) {
+    static_eval = evaluate(pos, b);
     if (depth <= 1 && static_eval + PARAM_FUTILITY_MARGIN <= alpha) return static_eval;
-    if (depth <= 2 && static_eval + PARAM_RAZOR_MARGIN <= alpha) return quiesce(b, alpha, beta, 0);
+    if (depth <= 2 && static_eval + PARAM_RAZOR_MARGIN <= alpha) return quiesce(pos, b, alpha, beta, 0);
   }
+  U64 pinned = board_pinned(b, b->side);
   U64 key = b->key;
   HashEntry *he = &tt[key & HASH_MASK];
   if (he->key == key && he->depth >= depth) {
     int tt_score = score_from_tt(he->score, b->ply);
-    int best_ok = he->best && move_is_legal(b, he->best);
+    int best_ok = move_is_valid(b, he->best, checkers, pinned);
     if (pv_best && best_ok) *pv_best = he->best;
     if (he->flag == 0 && (!pv_best || best_ok)) return tt_score;
     if (he->flag == 1 && tt_score >= beta) return tt_score;
     if (he->flag == 2 && tt_score <= alpha) return tt_score;
   }
-  MoveList ml;
-  gen_moves(b, &ml);
-  if (ml.n == 0) {
-    if (in_check) return -MATE + b->ply;
-    return (b->side == W ? PARAM_CONTEMPT : -PARAM_CONTEMPT);
-  }
   if (should_try_null(b, depth, in_check)) {
     NullState ns;
     make_null(b, &ns);
-    int null_score = -search_inner(b, depth - PARAM_NULL_REDUCTION - PARAM_NULL_DEPTH, -beta, -beta + 1, NULL, 0);
+    int null_score = -search_inner(pos, b, depth - PARAM_NULL_REDUCTION - PARAM_NULL_DEPTH, -beta, -beta + 1, NULL, 0);
     unmake_null(b, &ns);
     if (null_score >= beta) return beta;
   }
   int best = -INF;
   Move best_m = 0;
   Move hash_move = (he->key == key && he->best) ? he->best : 0;
-  int scores[MAX_MOVES];
-  score_moves(b, &ml, hash_move, prev_move, scores);
-  order_moves(&ml, scores);
-  if (hash_move)
-    for (int i = 0; i < ml.n; i++)
-      if (ml.m[i] == hash_move) { ml.m[i] = ml.m[0]; ml.m[0] = hash_move; scores[i] = scores[0]; scores[0] = PARAM_HASH_MOVE_TOP_SCORE; break; }
+  MovePicker mp;
+  CheckInfo ci;
+  check_info_init(b, &ci);
+  picker_init(&mp, b, hash_move, prev_move, checkers, pinned, &ci);
+  hash_move = mp.tt_move;
   int legal = 0;
   int first = 1;
-  for (int i = 0; i < ml.n; i++) {
-    Move m = ml.m[i];
+  Move m;
+  for (int i = 0; (m = picker_next(&mp)) != 0; i++) {
     if (is_root_excluded(b, m)) continue;
-    if (!move_is_legal(b, m)) continue;
     legal++;
-    int is_cap = (b->piece_on[TO(m)] >= 0) || (FLAGS(m) == M_EP);
+    tt_prefetch(key_after(b, m));
+    int is_cap = is_capture(b, m);
     if (should_lmp(depth, in_check, is_cap, i)) break;
     if (should_lmr(depth, is_cap, m, hash_move, i)) {
-      if (!make_move(b, m)) continue;
-      int gives_check = in_check_now(b);
+      int gives_check = move_gives_check(b, &ci, m);
+      Board *c = do_move(pos, b, m);
+      if (!c) continue;
       int rscore = alpha + 1;
       if (!gives_check) {
         int rdepth = depth - PARAM_LMR_REDUCTION;
-        if (rdepth <= 0) rscore = -quiesce(b, -beta, -alpha, 0);
-        else rscore = -search_inner(b, rdepth, -beta, -alpha, NULL, m);
+        if (rdepth <= 0) rscore = -quiesce(pos, c, -beta, -alpha, 0);
+        else rscore = -search_inner(pos, c, rdepth, -beta, -alpha, NULL, m);
       }
-      unmake_move(b, m);
+      undo_move(pos, m);
       if (!gives_check) {
         if (rscore <= alpha) continue;
         if (rscore >= beta) {
@@ -349,24 +515,25 @@ static int search_inner(Board *b, int depth, int alpha, int beta, Move *pv_best,
         }
       }
     }
-    if (!make_move(b, m)) continue;
-    int gives_check = in_check_now(b);
+    int gives_check = move_gives_check(b, &ci, m);
+    Board *c = do_move(pos, b, m);
+    if (!c) continue;
     int next_depth = depth - 1;
     if (gives_check && depth > 1 && next_depth < MAX_DEPTH - 1) next_depth += 1;
     int score;
     if (first) {
-      if (next_depth <= 0) score = -quiesce(b, -beta, -alpha, 0);
-      else score = -search_inner(b, next_depth, -beta, -alpha, NULL, m);
+      if (next_depth <= 0) score = -quiesce(pos, c, -beta, -alpha, 0);
+      else score = -search_inner(pos, c, next_depth, -beta, -alpha, NULL, m);
       first = 0;
     } else {
-      if (next_depth <= 0) score = -quiesce(b, -alpha - 1, -alpha, 0);
-      else score = -search_inner(b, next_depth, -alpha - 1, -alpha, NULL, m);
+      if (next_depth <= 0) score = -quiesce(pos, c, -alpha - 1, -alpha, 0);
+      else score = -search_inner(pos, c, next_depth, -alpha - 1, -alpha, NULL, m);
       if (score > alpha && score < beta) {
-        if (next_depth <= 0) score = -quiesce(b, -beta, -alpha, 0);
-        else score = -search_inner(b, next_depth, -beta, -alpha, NULL, m);
+        if (next_depth <= 0) score = -quiesce(pos, c, -beta, -alpha, 0);
+        else score = -search_inner(pos, c, next_depth, -beta, -alpha, NULL, m);
       }
     }
-    unmake_move(b, m);
+    undo_move(pos, m);
     if (score > best) {
       best = score;
       best_m = m;
@@ -384,14 +551,15 @@ static int search_inner(Board *b, int depth, int alpha, int beta, Move *pv_best,
   }
   if (legal == 0) {
     if (in_check) return -MATE + b->ply;
-    return 0;
+    return (b->side == W ? PARAM_CONTEMPT : -PARAM_CONTEMPT);
   }
-  if (search_abort) return eval(b);
+  if (search_abort) return evaluate(pos, b);
   tt_store(he, key, depth, alpha_orig, beta, best, best_m, b->ply);
   return best;
 }
 
-Move search(Board *b, int depth, int *score) {
+Move search(Position *pos, int depth, int *score) {
+  Board *b = &pos->b;
   if (PARAM_TT_CLEAR_ON_NEW_SEARCH) tt_clear();
   clear_search_heuristics();
   search_generation++;
@@ -399,6 +567,8 @@ Move search(Board *b, int depth, int *score) {
   search_abort = 0;
   search_nodes = 0;
   search_last_depth = 0;
+  eval_cache_reset_stats();
+  search_root_hply = pos->hply;
   search_start_time = clock();
   if (depth < 1) depth = 1;
   if (depth > MAX_DEPTH - 1) depth = MAX_DEPTH - 1;
@@ -434,6 +604,7 @@ Move search(Board *b, int depth, int *score) {
       if (capped < search_time_ms) search_time_ms = capped;
     }
   }
+  eval_set_profile(eval_profile_for_time(search_time_ms));
   if (search_time_ms > 0) {
     search_deadline = clock() + (clock_t)((search_time_ms * CLOCKS_PER_SEC) / 1000);
   }
@@ -452,6 +623,10 @@ Move search(Board *b, int depth, int *score) {
     return best;
   }
 
+#ifdef COPY_MAKE
+  pos->copy[pos->hply] = *b;
+  b = &pos->copy[pos->hply];
+#endif
   for (d = 1; d <= depth; d++) {
     Move pv_move = 0;
     int window_alpha = alpha, window_beta = beta;
@@ -468,7 +643,7 @@ Move search(Board *b, int depth, int *score) {
     }
     for (;;) {
       pv_move = 0;
-      s = search_inner(b, d, window_alpha, window_beta, &pv_move, 0);
+      s = search_inner(pos, b, d, window_alpha, window_beta, &pv_move, 0);
       if (search_abort) break;
       if (pv_move) best = pv_move;
       if (score) *score = s;
@@ -6,18 +6,18 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#ifdef HAVE_PEXT
+#include <cpuid.h>
+#endif
+
 static const int step[8] = {-8, -7, 1, 9, 8, 7, -1, -9};
 
-U64 knight_att[64];
-U64 king_att[64];
-U64 pawn_push[2][64];
-U64 pawn_att[2][64];
-U64 inv_pawn_att[2][64];
-U64 ray_att[64][8];
-int ray_dir[64][64];
-int pst[2][6][64];
+int slider_backend = SLIDER_MAGIC;
 int piece_val[6];
+Score piece_score[6];
+int piece_phase[6];
 HashEntry tt[HASH_SIZE];
+PawnEntry pawn_tt[PAWN_HASH_SIZE];
 static int tt_loaded_flag = 0;
 
 typedef struct {
@@ -35,58 +35,63 @@ typedef struct {
   Move best;
 } TTLegacyEntry;
 
-static void init_rays(void) {
-  int sq, dir, to;
-  for (sq = 0; sq < 64; sq++) {
-    for (dir = 0; dir < 8; dir++) {
-      U64 r = 0;
-      int d = step[dir];
-      int f = FILE(sq), rank = RANK(sq);
-      if (d == 1 || d == -1) {
-        for (to = sq + d; to >= 0 && to < 64 && (to / 8) == rank; to += d) r |= 1ULL << to;
-      } else if (d == 8 || d == -8) {
-        for (to = sq + d; to >= 0 && to < 64 && (to % 8) == f; to += d) r |= 1ULL << to;
-      } else {
-        for (to = sq + d; to >= 0 && to < 64; to += d) {
-          int df = FILE(to) - f, dr = RANK(to) - rank;
-          if (df < -1 || df > 1 || dr < -1 || dr > 1) break;
-          r |= 1ULL << to;
-          f = FILE(to);
-          rank = RANK(to);
-        }
-      }
-      ray_att[sq][dir] = r;
-    }
-    for (to = 0; to < 64; to++) ray_dir[sq][to] = -1;
-    for (dir = 0; dir < 8; dir++) {
-      U64 r = ray_att[sq][dir];
-      while (r) { to = POP(r); r &= r - 1; ray_dir[sq][to] = dir; }
-    }
+static const int bishop_dirs[4] = {1, 3, 5, 7};
+static const int rook_dirs[4] = {0, 2, 4, 6};
+
+static U64 ray_slide(int sq, const int *dirs, U64 occ) {
+  U64 att = 0;
+  for (int i = 0; i < 4; i++) {
+    int d = dirs[i];
+    U64 r = ray_att[sq][d];
+    U64 blk = r & occ;
+    if (blk) r ^= ray_att[step[d] > 0 ? POP(blk) : bit_msb64(blk)][d];
+    att |= r;
   }
+  return att;
 }
 
-static U64 rand64(void) {
-  static U64 s = 0x8a5cd789635d2dffULL;
-  s ^= s >> 12;
-  s ^= s << 25;
-  s ^= s >> 27;
-  return s * 2685821657736338717ULL;
+U64 slider_attacks_portable(int sq, U64 occ, int rook) {
+  return ray_slide(sq, rook ? rook_dirs : bishop_dirs, occ);
 }
 
-static U64 zobrist_piece[2][6][64];
-static U64 zobrist_side;
-static U64 zobrist_ep[8];
-static U64 zobrist_castle[4];
+/* 0 = no BMI2, 1 = BMI2 with microcoded PEXT (AMD before Zen 3), 2 = fast PEXT. */
+static int cpu_pext_level(void) {
+#ifdef HAVE_PEXT
+  unsigned a, b, c, d;
+  __builtin_cpu_init();
+  if (!__builtin_cpu_supports("bmi2")) return 0;
+  if (!__get_cpuid(0, &a, &b, &c, &d)) return 0;
+  if (b == 0x68747541) { /* "AuthenticAMD" */
+    if (!__get_cpuid(1, &a, &b, &c, &d)) return 1;
+    int fam = (a >> 8) & 0xF;
+    if (fam == 0xF) fam += (a >> 20) & 0xFF;
+    if (fam < 0x19) return 1;
+  }
+  return 2;
+#else
+  return 0;
+#endif
+}
 
-static void init_zobrist(void) {
-  int c, p, sq;
-  for (c = 0; c < 2; c++)
-    for (p = 0; p < 6; p++)
-      for (sq = 0; sq < 64; sq++)
-        zobrist_piece[c][p][sq] = rand64();
-  zobrist_side = rand64();
-  for (sq = 0; sq < 8; sq++) zobrist_ep[sq] = rand64();
-  for (sq = 0; sq < 4; sq++) zobrist_castle[sq] = rand64();
+const char *slider_backend_name(int backend) {
+  if (backend == SLIDER_PORTABLE) return "portable";
+  if (backend == SLIDER_PEXT) return "pext";
+  return "magic";
+}
+
+int slider_pick(const char *override) {
+  int level = cpu_pext_level();
+  if (!override || !*override) override = getenv("SLIDER_BACKEND");
+  if (override && *override) {
+    if (strcmp(override, "portable") == 0) return SLIDER_PORTABLE;
+    if (strcmp(override, "magic") == 0) return SLIDER_MAGIC;
+    if (strcmp(override, "pext") == 0) return level > 0 ? SLIDER_PEXT : SLIDER_MAGIC;
+  }
+  return level == 2 ? SLIDER_PEXT : SLIDER_MAGIC;
+}
+
+void init_sliders(int backend) {
+  slider_backend = backend;
 }
 
 U64 tables_compute_key(const Board *b) {
@@ -106,89 +111,35 @@ U64 tables_compute_key(const Board *b) {
   return k;
 }
 
+U64 tables_compute_pawn_key(const Board *b) {
+  U64 k = 0;
+  for (int c = 0; c < 2; c++) {
+    U64 bb = b->p[c][P];
+    while (bb) { int sq = POP(bb); bb &= bb - 1; k ^= zobrist_piece[c][P][sq]; }
+  }
+  return k;
+}
+
 U64 tables_key_after_null(const Board *b) {
   U64 k = b->key ^ zobrist_side;
   if (b->ep >= 0 && b->ep < 64) k ^= zobrist_ep[FILE(b->ep)];
   return k;
 }
 
-int tables_zobrist_ready(void) {
-  return zobrist_piece[0][0][1] != 0;
-}
-
-void tables_ensure_zobrist(void) {
-  if (!tables_zobrist_ready()) init_zobrist();
-}
-
 void init_tables(void) {
-  int sq, i;
-  init_rays();
-  init_zobrist();
-  for (sq = 0; sq < 64; sq++) {
-    U64 k = 0;
-    int f = FILE(sq), r = RANK(sq);
-    for (i = 0; i < 8; i++) {
-      int nr = r + (i < 4 ? (i < 2 ? -1 : 1) : 0);
-      int nf = f + (i == 0 || i == 4 ? 0 : (i == 1 || i == 3 || i == 5 ? 1 : -1));
-      if (i == 0) nf = f - 1;
-      if (i == 1) { nf = f + 1; nr = r - 1; }
-      if (i == 2) { nf = f + 1; nr = r; }
-      if (i == 3) { nf = f + 1; nr = r + 1; }
-      if (i == 4) nr = r + 1;
-      if (i == 5) { nf = f - 1; nr = r + 1; }
-      if (i == 6) nf = f - 1;
-      if (i == 7) { nf = f - 1; nr = r - 1; }
-      if (nf >= 0 && nf < 8 && nr >= 0 && nr < 8) k |= 1ULL << SQ(nf, nr);
-    }
-    king_att[sq] = k;
-    k = 0;
-    int dn[8][2] = {{-2,-1},{-2,1},{-1,-2},{-1,2},{1,-2},{1,2},{2,-1},{2,1}};
-    for (i = 0; i < 8; i++) {
-      int nf = f + dn[i][0], nr = r + dn[i][1];
-      if (nf >= 0 && nf < 8 && nr >= 0 && nr < 8) k |= 1ULL << SQ(nf, nr);
-    }
-    knight_att[sq] = k;
-    pawn_push[W][sq] = (r < 7) ? (1ULL << (sq + 8)) : 0;
-    if (r == 1) pawn_push[W][sq] |= 1ULL << (sq + 16);
-    pawn_push[B][sq] = (r > 0) ? (1ULL << (sq - 8)) : 0;
-    if (r == 6) pawn_push[B][sq] |= 1ULL << (sq - 16);
-    pawn_att[W][sq] = 0;
-    if (r < 7) {
-      if (f > 0) pawn_att[W][sq] |= 1ULL << (sq + 7);
-      if (f < 7) pawn_att[W][sq] |= 1ULL << (sq + 9);
-    }
-    pawn_att[B][sq] = 0;
-    if (r > 0) {
-      if (f > 0) pawn_att[B][sq] |= 1ULL << (sq - 9);
-      if (f < 7) pawn_att[B][sq] |= 1ULL << (sq - 7);
-    }
-    inv_pawn_att[W][sq] = (r >= 1 && f >= 1 ? (1ULL << (sq - 7)) : 0) | (r >= 1 && f <= 6 ? (1ULL << (sq - 9)) : 0);
-    inv_pawn_att[B][sq] = (r <= 6 && f <= 6 ? (1ULL << (sq + 7)) : 0) | (r <= 6 && f >= 1 ? (1ULL << (sq + 9)) : 0);
-  }
   piece_val[P] = PARAM_VAL_PAWN;
   piece_val[N] = PARAM_VAL_KNIGHT;
   piece_val[BISHOP] = PARAM_VAL_BISHOP;
   piece_val[R] = PARAM_VAL_ROOK;
   piece_val[Q] = PARAM_VAL_QUEEN;
   piece_val[K] = PARAM_VAL_KING;
-  for (sq = 0; sq < 64; sq++) {
-    int r = RANK(sq), f = FILE(sq);
-    int cr = r < 4 ? r : 7 - r;
-    int cf = f < 4 ? f : 7 - f;
-    int c = cr + cf;
-    pst[W][P][sq] = (r >= 1 && r <= 5) ? (r - 1) * 8 + (f >= 2 && f <= 5 ? 10 : 0) : (r == 6 ? 50 : 0);
-    pst[B][P][sq] = pst[W][P][63 - sq];
-    pst[W][N][sq] = c * 5 + (r >= 2 && r <= 5 && f >= 2 && f <= 5 ? 15 : 0);
-    pst[B][N][sq] = pst[W][N][63 - sq];
-    pst[W][BISHOP][sq] = c * 4 + (f == r || f == 7 - r ? 12 : 0);
-    pst[B][BISHOP][sq] = pst[W][BISHOP][63 - sq];
-    pst[W][R][sq] = (r == 6 ? 25 : 0) + (f == 0 || f == 7 ? -5 : 0) + (r == 7 ? 12 : 0);
-    pst[B][R][sq] = pst[W][R][63 - sq];
-    pst[W][Q][sq] = c * 3 + (r >= 2 && r <= 5 ? 8 : 0);
-    pst[B][Q][sq] = pst[W][Q][63 - sq];
-    pst[W][K][sq] = (r == 0 && f >= 2 && f <= 6 ? -30 : 0) + (r >= 1 ? (c * 4) : 0);
-    pst[B][K][sq] = pst[W][K][63 - sq];
-  }
+  for (int p = 0; p < 6; p++) piece_score[p] = S(piece_val[p], piece_val[p]);
+  piece_phase[P] = PARAM_PHASE_PAWN;
+  piece_phase[N] = PARAM_PHASE_KNIGHT;
+  piece_phase[BISHOP] = PARAM_PHASE_BISHOP;
+  piece_phase[R] = PARAM_PHASE_ROOK;
+  piece_phase[Q] = PARAM_PHASE_QUEEN;
+  piece_phase[K] = 0;
 }
 
 void tt_clear(void) {
@@ -69,15 +69,14 @@ int uci_to_move(const Board *b, const char *uci, Move *out) {
   {
     int stm = b->side;
     int at_from = b->piece_on[from];
-    if (at_from < 0 || (at_from / 6) != stm) {
-      at_from = -1;
+    if (PCOLOR(at_from) != stm) {
       for (int pc = 0; pc < 6; pc++)
         if ((b->p[stm][pc] >> from) & 1) {
-          ((Board *)b)->piece_on[from] = stm * 6 + pc;
+          ((Board *)b)->piece_on[from] = MAKE_PIECE(stm, pc);
           break;
         }
     }
-    if (b->piece_on[from] < 0 || (b->piece_on[from] / 6) != stm) {
+    if (PCOLOR(b->piece_on[from]) != stm) {
       snprintf(uci_err, sizeof(uci_err), "no piece on source square %c%c", 'a' + (from & 7), '1' + (from >> 3));
       return 0;
     }
@@ -0,0 +1,34 @@
+#!/usr/bin/env bash
+# Eval profile bench: NPS, mean depth and solve rate on a tactical suite for each profile.
+# BENCH_MS sets the time per position (default 1000); profiles are forced with EVAL_PROFILE.
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+cd "$ROOT"
+ENGINE="${ENGINE:-./engine}"
+MS="${BENCH_MS:-1000}"
+SUITE='2rr3k/pp3pp1/1nnqbN1p/3pN3/2pP4/2P3Q1/PPB4P/R4RK1 w - - 0 1|g3g6
+8/7p/5k2/5p2/p1p2P2/Pr1pPK2/1P1R3P/8 b - - 0 1|b3b2
+5rk1/1ppb3p/p1pb4/6q1/3P1p1r/2P1R2P/PP1BQ1P1/5RKN w - - 0 1|e3g3
+r1bq2rk/pp3pbp/2p1p1pQ/7P/3P4/2PB1N2/PP3PPR/2KR4 w - - 0 1|h6h7
+5k2/6pp/p1qN4/1p1p4/3P4/2PKP2Q/PP3r2/3R4 b - - 0 1|c6c4
+7k/p7/1R5K/6r1/6p1/6P1/8/8 w - - 0 1|b6b7
+rnbqkb1r/pppp1ppp/8/4P3/6n1/7P/PPPNPPP1/R1BQKBNR b KQkq - 0 1|g4e3
+r4q1k/p2bR1rp/2p2Q1N/5p2/5p2/2P5/PP3PPP/R5K1 w - - 0 1|e7f7
+3q1rk1/p4pp1/2pb3p/3p4/6Pr/1PNQ4/P1PB1PP1/4RRK1 b - - 0 1|d6h2
+2br2k1/2q3rn/p2NppQ1/2p1P3/Pp5R/4P3/1P3PPP/3R2K1 w - - 0 1|h4h7'
+
+printf "%-9s %8s %6s %7s\n" profile knps depth solved
+for profile in material pawns full; do
+  solved=0 total=0 nodes=0 ms=0 depth=0
+  while IFS='|' read -r fen bm; do
+    line=$(EVAL_PROFILE=$profile MOVE_TIME_MS=$MS TT_LOAD=0 TT_SAVE=0 $ENGINE "$fen" 2>/dev/null | head -1)
+    total=$((total + 1))
+    [ "${line%% *}" = "$bm" ] && solved=$((solved + 1))
+    kn=$(echo "$line" | grep -oE 'kn=[0-9]+' | cut -d= -f2)
+    t=$(echo "$line" | awk '{print $2}' | tr -d 'ms')
+    d=$(echo "$line" | grep -oE 'd=[0-9]+' | cut -d= -f2)
+    depth=$((depth + ${d:-0}))
+    nodes=$((nodes + ${kn:-0}))
+    ms=$((ms + ${t:-0}))
+  done <<< "$SUITE"
+  printf "%-9s %8d %3d.%d %4d/%d\n" $profile $((ms > 0 ? nodes * 1000 / ms : 0)) $((depth / total)) $((depth * 10 / total % 10)) $solved $total
+done
@@ -0,0 +1,36 @@
+#!/usr/bin/env bash
+# Perft regression suite: checks node counts and reports Mnps.
+# PERFT_THREADS / PERFT_HASH_MB are passed through to the engine.
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+cd "$ROOT"
+ENGINE="${ENGINE:-./engine}"
+FAIL=0
+TOTAL_NODES=0
+TOTAL_MS=0
+
+while IFS='|' read -r depth expected fen; do
+  [ -z "$depth" ] && continue
+  line=$($ENGINE perft "$depth" "$fen" 2>/dev/null | tail -1)
+  nodes=$(echo "$line" | awk '{print $1}')
+  ms=$(echo "$line" | awk '{print $2}' | tr -d 'ms')
+  if [ "$nodes" = "$expected" ]; then
+    echo "  ok    d=$depth $nodes ${ms}ms  $fen"
+  else
+    echo "  FAIL  d=$depth got=$nodes want=$expected  $fen"
+    FAIL=$((FAIL + 1))
+  fi
+  TOTAL_NODES=$((TOTAL_NODES + ${nodes:-0}))
+  TOTAL_MS=$((TOTAL_MS + ${ms:-0}))
+done <<'SUITE'
+6|119060324|rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1
+5|193690690|r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1
+7|178633661|8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1
+5|15833292|r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1
+5|89941194|rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8
+5|164075551|r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10
+SUITE
+
+if [ "$TOTAL_MS" -gt 0 ]; then
+  echo "nodes=$TOTAL_NODES ${TOTAL_MS}ms Mnps=$((TOTAL_NODES / TOTAL_MS / 1000))"
+fi
+[ "$FAIL" -eq 0 ]
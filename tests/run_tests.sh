@@ -12,7 +12,7 @@ else
   RUN_TIMEOUT="perl -e 'alarm shift; exec @ARGV' $TIMEOUT"
 fi
 UCI_MOVE_PATTERN='^[a-h][1-8][a-h][1-8][nbrq]?$'
-UCI_MOVE_WITH_TIME_PATTERN='^([a-h][1-8][a-h][1-8][nbrq]?|\\(none\\))( [0-9]+ms)?( d=[0-9]+)?( kn=[0-9]+)?( nps=[0-9]+)?$'
+UCI_MOVE_WITH_TIME_PATTERN='^([a-h][1-8][a-h][1-8][nbrq]?|\\(none\\))( [0-9]+ms)?( d=[0-9]+)?( kn=[0-9]+)?( nps=[0-9]+)?( evhit=[0-9]+%)?$'
 PASS=0
 FAIL=0
 
@@ -95,6 +95,75 @@ run_test "Engine exits cleanly on empty/closed stdin" "
   [ \$? -eq 0 ] || [ \$? -eq 124 ]
 "
 
+echo ""
+echo "--- Test 7: Perft node counts ---"
+run_test "perft matches known counts" "
+  a=\$($RUN_TIMEOUT $ENGINE perft 4 2>/dev/null | tail -1 | awk '{print \$1}')
+  b=\$($RUN_TIMEOUT $ENGINE perft 3 'r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1' 2>/dev/null | tail -1 | awk '{print \$1}')
+  [ \"\$a\" = 197281 ] && [ \"\$b\" = 97862 ]
+"
+
+echo ""
+echo "--- Test 8: Missing NNUE network falls back to the classic eval ---"
+run_test "EVAL_NNUE with a bad path still plays" "
+  err=\$(EVAL_NNUE=/nonexistent.nnue MOVE_TIME_MS=200 $RUN_TIMEOUT $ENGINE 2>&1 >/dev/null)
+  out=\$(EVAL_NNUE=/nonexistent.nnue MOVE_TIME_MS=200 $RUN_TIMEOUT $ENGINE 2>/dev/null | head -1)
+  echo \"\$err\" | grep -q 'eval: classic' && echo \"\$out\" | grep -qE \"\$UCI_MOVE_WITH_TIME_PATTERN\"
+"
+
+echo ""
+echo "--- Test 9: Batch eval ---"
+run_test "evalbatch scores every line the same on any thread count" "
+  fens=\$(mktemp)
+  for i in \$(seq 100); do
+    echo 'rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1'
+    echo 'rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq - 0 1'
+    echo 'r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1'
+    echo '8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1'
+  done > \$fens
+  a=\$(EVAL_THREADS=1 $RUN_TIMEOUT $ENGINE evalbatch \$fens 2>/dev/null)
+  b=\$(EVAL_THREADS=3 $RUN_TIMEOUT $ENGINE evalbatch \$fens 2>/dev/null)
+  rm -f \$fens
+  [ \$(echo \"\$a\" | wc -l) -eq 400 ] && [ \"\$a\" = \"\$b\" ] && [ \$(echo \"\$a\" | sort -u | wc -l) -eq 4 ]
+"
+
+echo ""
+echo "--- Test 10: Endgame recognizers ---"
+run_test "dead draws score 0, the right bishop still wins" "
+  fens=\$(mktemp)
+  printf '%s\\n' '8/8/4k3/8/3B4/3KB3/8/8 w - - 0 1' '8/8/4k3/8/8/3KNN2/8/8 w - - 0 1' \\
+    '7k/8/7P/8/8/3K1B2/8/8 w - - 0 1' '7k/8/7P/8/8/3KB3/8/8 w - - 0 1' > \$fens
+  out=\$($RUN_TIMEOUT $ENGINE evalbatch \$fens 2>/dev/null | tr '\\n' ' ')
+  rm -f \$fens
+  echo \"\$out\" | grep -qE '^0 0 0 [1-9][0-9]* \$'
+"
+
+echo ""
+echo "--- Test 11: Bitbases ---"
+run_test "generated KPK bitbase finds the only winning moves and settles a draw" "
+  dir=\$(mktemp -d)
+  make -C \"$ROOT\" tools/bitbase_gen 1>/dev/null 2>&1 && ./tools/bitbase_gen \$dir KQK KRK KPK 2>/dev/null
+  won=\$(BITBASE_DIR=\$dir TT_LOAD=0 TT_SAVE=0 MOVE_TIME_MS=2000 $RUN_TIMEOUT $ENGINE '4k3/8/8/8/8/8/4P3/4K3 w - - 0 1' 2>/dev/null)
+  drawn=\$(BITBASE_DIR=\$dir TT_LOAD=0 TT_SAVE=0 MOVE_TIME_MS=2000 $RUN_TIMEOUT $ENGINE '8/8/8/4k3/8/8/4P3/4K3 w - - 0 1' 2>/dev/null)
+  rm -rf \$dir
+  echo \"\$won\" | grep -qE '^e1[df]2 .* d=52 ' && echo \"\$drawn\" | grep -q ' d=52 '
+"
+
+echo ""
+echo "--- Test 12: NNUE incremental updates ---"
+run_test "incremental accumulators match a full refresh on every kernel" "
+  net=\$(mktemp)
+  { printf 'NNUEv1\\000\\000\\000\\001\\000\\000\\100\\240\\000\\000\\040\\000\\000\\000\\040\\000\\000\\000'
+    head -c 40 /dev/zero; head -c 21022500 /dev/urandom; } > \$net
+  ok=1
+  for k in scalar sse41 avx2; do
+    out=\$(NNUE_SIMD=\$k EVAL_NNUE=\$net $RUN_TIMEOUT $ENGINE nnuecheck 2>/dev/null)
+    echo \"\$out\" | grep -qE \"^nnuecheck: \$k [0-9]+ positions 0 mismatches\\$\" || ok=0
+  done
+  rm -f \$net
+  [ \$ok -eq 1 ]
+"
+
 echo ""
 echo "=========================================="
 echo "Results: $PASS passed, $FAIL failed"
@@ -0,0 +1,272 @@
+/* Retrograde WDL bitbase generator (make bitbases). Builds each table in
+   bitbase.c order: every legal position is scored from its exits (captures
+   and promotions, probed in the tables already built or the draw
+   recognizers), then wins and losses are propagated backwards one ply per
+   round with un-moves until nothing changes; what remains is a draw. */
+#include "bitbase.h"
+#include "board.h"
+#include "endgame.h"
+#include "movegen.h"
+#include "tables.h"
+#include "types.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define GEN_MAX_THREADS 64
+#define GEN_CHUNK 4096
+#define V_INVALID 4
+#define ROUND_NONE 255
+
+typedef struct {
+  const BitbaseDef *d;
+  uint8_t *val, *cnt, *rnd;
+  int policy, round, unresolved;
+  U64 next, changed;
+} Gen;
+
+static int gen_threads = 1;
+
+static long long wall_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int decode(const BitbaseDef *d, U64 i, int *sq) {
+  for (int k = d->n - 1; k >= 0; k--) {
+    int r = d->type[k] == P ? 48 : 64;
+    sq[k] = (int)(i % (U64)r) + (d->type[k] == P ? 8 : 0);
+    i /= (U64)r;
+  }
+  return (int)i;
+}
+
+/* A capture or promotion: the child's value from its side to move. Exits into
+   a table that is not built (KRKP underpromotions) count as wins for the
+   child under policy 0 and losses under policy 1. */
+static int exit_value(Gen *g, const Board *c) {
+  int v = bitbase_probe(c, NULL), scale;
+  if (v != BB_UNKNOWN) return v;
+  if (endgame_probe(c, &scale) == EG_DRAW) return BB_DRAW;
+  __atomic_store_n(&g->unresolved, 1, __ATOMIC_RELAXED);
+  return g->policy ? BB_LOSS : BB_WIN;
+}
+
+static void init_position(Gen *g, U64 i) {
+  const BitbaseDef *d = g->d;
+  int sq[BITBASE_MAX_PIECES];
+  int stm = decode(d, i, sq);
+  Board b;
+  memset(&b, 0, sizeof b);
+  U64 occ = 0;
+  for (int k = 0; k < d->n; k++) {
+    if (occ & (1ULL << sq[k])) { g->val[i] = V_INVALID; return; }
+    occ |= 1ULL << sq[k];
+    b.p[d->color[k]][d->type[k]] |= 1ULL << sq[k];
+  }
+  b.side = (uint8_t)stm;
+  b.ep = -1;
+  board_sync(&b);
+  if (is_attacked(&b, b.king_sq[stm ^ 1], stm ^ 1)) { g->val[i] = V_INVALID; return; }
+  MoveList ml;
+  gen_legal(&b, &ml, GEN_ALL);
+  if (!ml.n) {
+    g->val[i] = board_checkers(&b) ? BB_LOSS : BB_DRAW;
+    if (g->val[i] == BB_LOSS) g->rnd[i] = 0;
+    return;
+  }
+  int n = 0, escape = 0;
+  for (int j = 0; j < ml.n; j++) {
+    Move m = ml.m[j];
+    if (b.piece_on[TO(m)] == NO_PIECE && FLAGS(m) != M_PROMO) { n++; continue; }
+    Board c = b;
+    Hist h;
+    board_make(&c, m, &h);
+    int v = exit_value(g, &c);
+    if (v == BB_LOSS) { g->val[i] = BB_WIN; g->rnd[i] = 0; return; }
+    if (v == BB_DRAW) escape = 1;
+  }
+  if (!n && !escape) { g->val[i] = BB_LOSS; g->rnd[i] = 0; return; }
+  g->cnt[i] = (uint8_t)(n + escape);
+}
+
+/* Squares the mover's piece on sq can have come from without capturing. */
+static U64 unmoves(int type, int color, int sq, U64 occ) {
+  switch (type) {
+    case P: {
+      int dir = color == W ? -8 : 8, from = sq + dir;
+      if (RANK(from) < 1 || RANK(from) > 6 || (occ & (1ULL << from))) return 0;
+      U64 set = 1ULL << from;
+      if (RANK(sq) == (color == W ? 3 : 4) && !(occ & (1ULL << (from + dir)))) set |= 1ULL << (from + dir);
+      return set;
+    }
+    case N: return knight_att[sq] & ~occ;
+    case BISHOP: return bishop_attacks(sq, occ) & ~occ;
+    case R: return rook_attacks(sq, occ) & ~occ;
+    case Q: return queen_attacks(sq, occ) & ~occ;
+    default: return king_att[sq] & ~occ;
+  }
+}
+
+static void settle(Gen *g, U64 q, int v) {
+  uint8_t expect = 0;
+  if (!__atomic_compare_exchange_n(&g->val[q], &expect, (uint8_t)v, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) return;
+  g->rnd[q] = (uint8_t)g->round;
+  __atomic_fetch_add(&g->changed, 1, __ATOMIC_RELAXED);
+}
+
+/* Positions decided last round settle their predecessors: a loss makes every
+   move into it winning, a win removes one option from each predecessor. */
+static void propagate_position(Gen *g, U64 i) {
+  const BitbaseDef *d = g->d;
+  int sq[BITBASE_MAX_PIECES];
+  int stm = decode(d, i, sq), mover = stm ^ 1, v = g->val[i];
+  U64 occ = 0;
+  for (int k = 0; k < d->n; k++) occ |= 1ULL << sq[k];
+  for (int k = 0; k < d->n; k++) {
+    if (d->color[k] != mover) continue;
+    U64 from = unmoves(d->type[k], mover, sq[k], occ);
+    int to = sq[k];
+    while (from) {
+      sq[k] = POP(from);
+      from &= from - 1;
+      U64 q = bitbase_index(d, sq, mover);
+      if (g->val[q] != 0) continue;
+      if (v == BB_LOSS) settle(g, q, BB_WIN);
+      else if (__atomic_sub_fetch(&g->cnt[q], 1, __ATOMIC_RELAXED) == 0) settle(g, q, BB_LOSS);
+    }
+    sq[k] = to;
+  }
+}
+
+static void *init_worker(void *arg) {
+  Gen *g = arg;
+  for (;;) {
+    U64 start = __atomic_fetch_add(&g->next, GEN_CHUNK, __ATOMIC_RELAXED);
+    if (start >= g->d->size) break;
+    U64 end = start + GEN_CHUNK < g->d->size ? start + GEN_CHUNK : g->d->size;
+    for (U64 i = start; i < end; i++) init_position(g, i);
+  }
+  return NULL;
+}
+
+static void *propagate_worker(void *arg) {
+  Gen *g = arg;
+  for (;;) {
+    U64 start = __atomic_fetch_add(&g->next, GEN_CHUNK, __ATOMIC_RELAXED);
+    if (start >= g->d->size) break;
+    U64 end = start + GEN_CHUNK < g->d->size ? start + GEN_CHUNK : g->d->size;
+    for (U64 i = start; i < end; i++)
+      if (g->rnd[i] == g->round - 1) propagate_position(g, i);
+  }
+  return NULL;
+}
+
+static void run(Gen *g, void *(*fn)(void *)) {
+  pthread_t tid[GEN_MAX_THREADS];
+  int started = 0;
+  g->next = 0;
+  for (int t = 1; t < gen_threads; t++)
+    if (pthread_create(&tid[started], NULL, fn, g) == 0) started++;
+  fn(g);
+  for (int t = 0; t < started; t++) pthread_join(tid[t], NULL);
+}
+
+/* One full retrograde pass; leaves val holding V_INVALID or a BB_* value. */
+static int solve(Gen *g) {
+  memset(g->val, 0, (size_t)g->d->size);
+  memset(g->cnt, 0, (size_t)g->d->size);
+  memset(g->rnd, ROUND_NONE, (size_t)g->d->size);
+  run(g, init_worker);
+  int rounds = 0;
+  for (g->round = 1; g->round < ROUND_NONE; g->round++) {
+    g->changed = 0;
+    run(g, propagate_worker);
+    if (!g->changed) break;
+    rounds = g->round;
+  }
+  for (U64 i = 0; i < g->d->size; i++)
+    if (!g->val[i]) g->val[i] = BB_DRAW;
+  return rounds;
+}
+
+static int generate(int id, const char *dir) {
+  const BitbaseDef *d = &bitbase_defs[id];
+  long long start = wall_ms();
+  Gen g = { 0 };
+  g.d = d;
+  g.val = malloc((size_t)d->size);
+  g.cnt = malloc((size_t)d->size);
+  g.rnd = malloc((size_t)d->size);
+  uint8_t *packed = calloc((size_t)((d->size + 3) / 4), 1);
+  uint8_t *low = NULL;
+  if (!g.val || !g.cnt || !g.rnd || !packed) return 0;
+  int rounds = solve(&g);
+  /* Unbuilt exits: solve again with them favouring the other side and keep
+     only the positions both passes agree on. */
+  if (g.unresolved && (low = malloc((size_t)d->size))) {
+    memcpy(low, g.val, (size_t)d->size);
+    g.policy = 1;
+    int high = solve(&g);
+    if (high > rounds) rounds = high;
+  }
+  U64 count[5] = { 0 };
+  for (U64 i = 0; i < d->size; i++) {
+    int v = g.val[i];
+    if (low && low[i] != v) v = BB_UNKNOWN;
+    count[v]++;
+    if (v == V_INVALID) v = BB_UNKNOWN;
+    packed[i >> 2] |= (uint8_t)(v << ((i & 3) * 2));
+  }
+  free(low);
+  free(g.val);
+  free(g.cnt);
+  free(g.rnd);
+
+  char path[512], tmp[520];
+  snprintf(path, sizeof path, "%s/%s.bb", dir, d->name);
+  snprintf(tmp, sizeof tmp, "%s.tmp", path);
+  BitbaseHeader h = { { 'B', 'B', 'v', '2' }, (uint16_t)id, (uint16_t)(rounds + 1), d->size };
+  FILE *f = fopen(tmp, "wb");
+  int ok = f && fwrite(&h, sizeof h, 1, f) == 1 && fwrite(packed, 1, (size_t)((d->size + 3) / 4), f) == (size_t)((d->size + 3) / 4);
+  if (f && fclose(f) != 0) ok = 0;
+  if (!ok || rename(tmp, path) != 0) {
+    fprintf(stderr, "bitbase: cannot write %s\n", path);
+    return 0;
+  }
+  bitbase_attach(id, packed, rounds + 1);
+  fprintf(stderr, "bitbase: %s win %llu draw %llu loss %llu unknown %llu illegal %llu, %d rounds, %lldms\n", d->name,
+          (unsigned long long)count[BB_WIN], (unsigned long long)count[BB_DRAW], (unsigned long long)count[BB_LOSS],
+          (unsigned long long)count[BB_UNKNOWN], (unsigned long long)count[V_INVALID], rounds, wall_ms() - start);
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: bitbase_gen <dir> [KQK KRK ...]\n");
+    return 1;
+  }
+  const char *env = getenv("BITBASE_THREADS");
+  gen_threads = env && *env ? atoi(env) : 0;
+#if defined(_SC_NPROCESSORS_ONLN)
+  if (gen_threads < 1) gen_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if (gen_threads < 1) gen_threads = 1;
+  if (gen_threads > GEN_MAX_THREADS) gen_threads = GEN_MAX_THREADS;
+  init_tables();
+  init_sliders(slider_pick(NULL));
+  endgame_init();
+  /* Tables already in dir stand in for the ones not asked for. */
+  bitbase_load(argv[1]);
+  for (int id = 0; id < BITBASE_TABLES; id++) {
+    int want = argc == 2;
+    for (int a = 2; a < argc; a++) want |= strcmp(argv[a], bitbase_defs[id].name) == 0;
+    if (want && !generate(id, argv[1])) return 1;
+  }
+  return 0;
+}
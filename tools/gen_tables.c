@@ -0,0 +1,384 @@
+/* Build-time table generator: prints src/tables_gen.c with every attack, PST
+   and Zobrist table as const data, so engine startup does no table work. */
+#include "types.h"
+
+#include <stdio.h>
+
+static const int step[8] = {-8, -7, 1, 9, 8, 7, -1, -9};
+static const int bishop_dirs[4] = {1, 3, 5, 7};
+static const int rook_dirs[4] = {0, 2, 4, 6};
+
+static U64 knight_att[64];
+static U64 king_att[64];
+static U64 pawn_push[2][64];
+static U64 pawn_att[2][64];
+static U64 inv_pawn_att[2][64];
+static U64 ray_att[64][8];
+static int ray_dir[64][64];
+static U64 between_bb[64][64];
+static U64 line_bb[64][64];
+static int pst[2][6][64];
+static int pst_score[2][6][64];
+static U64 isolated_mask[8];
+static U64 passed_mask[2][64];
+static U64 zobrist_piece[2][6][64];
+static U64 zobrist_side;
+static U64 zobrist_ep[8];
+static U64 zobrist_castle[4];
+static U64 zobrist_castle_set[16];
+
+typedef struct { U64 mask; U64 magic; int offset; int shift; } GenMagic;
+static GenMagic bishop_magic[64], rook_magic[64];
+static U64 slider_att[5248 + 102400];
+static U64 slider_att_pext[5248 + 102400];
+static U64 cuckoo_key[CUCKOO_SIZE];
+static int cuckoo_move[CUCKOO_SIZE];
+
+/* Multipliers found offline with a sparse-random search; fixed shift per square. */
+static const U64 bishop_magic_num[64] = {
+  0x40106000a1160020ULL, 0x0020010250810120ULL, 0x2010010220280081ULL, 0x002806004050c040ULL,
+  0x0002021018000000ULL, 0x2001112010000400ULL, 0x0881010120218080ULL, 0x1030820110010500ULL,
+  0x0000120222042400ULL, 0x2000020404040044ULL, 0x8000480094208000ULL, 0x0003422a02000001ULL,
+  0x000a220210100040ULL, 0x8004820202226000ULL, 0x0018234854100800ULL, 0x0100004042101040ULL,
+  0x0004001004082820ULL, 0x0010000810010048ULL, 0x1014004208081300ULL, 0x2080818802044202ULL,
+  0x0040880c00a00100ULL, 0x0080400200522010ULL, 0x0001000188180b04ULL, 0x0080249202020204ULL,
+  0x1004400004100410ULL, 0x00013100a0022206ULL, 0x2148500001040080ULL, 0x4241080011004300ULL,
+  0x4020848004002000ULL, 0x10101380d1004100ULL, 0x0008004422020284ULL, 0x01010a1041008080ULL,
+  0x0808080400082121ULL, 0x0808080400082121ULL, 0x0091128200100c00ULL, 0x0202200802010104ULL,
+  0x8c0a020200440085ULL, 0x01a0008080b10040ULL, 0x0889520080122800ULL, 0x100902022202010aULL,
+  0x04081a0816002000ULL, 0x0000681208005000ULL, 0x8170840041008802ULL, 0x0a00004200810805ULL,
+  0x0830404408210100ULL, 0x2602208106006102ULL, 0x1048300680802628ULL, 0x2602208106006102ULL,
+  0x0602010120110040ULL, 0x0941010801043000ULL, 0x000040440a210428ULL, 0x0008240020880021ULL,
+  0x0400002012048200ULL, 0x00ac102001210220ULL, 0x0220021002009900ULL, 0x84440c080a013080ULL,
+  0x0001008044200440ULL, 0x0004c04410841000ULL, 0x2000500104011130ULL, 0x1a0c010011c20229ULL,
+  0x0044800112202200ULL, 0x0434804908100424ULL, 0x0300404822c08200ULL, 0x48081010008a2a80ULL,
+};
+
+static const U64 rook_magic_num[64] = {
+  0x0a80004000801220ULL, 0x8040004010002008ULL, 0x2080200010008008ULL, 0x1100100008210004ULL,
+  0xc200209084020008ULL, 0x2100010004000208ULL, 0x0400081000822421ULL, 0x0200010422048844ULL,
+  0x0800800080400024ULL, 0x0001402000401000ULL, 0x3000801000802001ULL, 0x4400800800100083ULL,
+  0x0904802402480080ULL, 0x4040800400020080ULL, 0x0018808042000100ULL, 0x4040800080004100ULL,
+  0x0040048001458024ULL, 0x00a0004000205000ULL, 0x3100808010002000ULL, 0x4825010010000820ULL,
+  0x5004808008000401ULL, 0x2024818004000a00ULL, 0x0005808002000100ULL, 0x2100060004806104ULL,
+  0x0080400880008421ULL, 0x4062220600410280ULL, 0x010a004a00108022ULL, 0x0000100080080080ULL,
+  0x0021000500080010ULL, 0x0044000202001008ULL, 0x0000100400080102ULL, 0xc020128200040545ULL,
+  0x0080002000400040ULL, 0x0000804000802004ULL, 0x0000120022004080ULL, 0x010a386103001001ULL,
+  0x9010080080800400ULL, 0x8440020080800400ULL, 0x0004228824001001ULL, 0x000000490a000084ULL,
+  0x0080002000504000ULL, 0x200020005000c000ULL, 0x0012088020420010ULL, 0x0010010080080800ULL,
+  0x0085001008010004ULL, 0x0002000204008080ULL, 0x0040413002040008ULL, 0x0000304081020004ULL,
+  0x0080204000800080ULL, 0x3008804000290100ULL, 0x1010100080200080ULL, 0x2008100208028080ULL,
+  0x5000850800910100ULL, 0x8402019004680200ULL, 0x0120911028020400ULL, 0x0000008044010200ULL,
+  0x0020850200244012ULL, 0x0020850200244012ULL, 0x0000102001040841ULL, 0x140900040a100021ULL,
+  0x000200282410a102ULL, 0x000200282410a102ULL, 0x000200282410a102ULL, 0x4048240043802106ULL,
+};
+
+static void init_rays(void) {
+  int sq, dir, to;
+  for (sq = 0; sq < 64; sq++) {
+    for (dir = 0; dir < 8; dir++) {
+      U64 r = 0;
+      int d = step[dir];
+      int f = FILE(sq), rank = RANK(sq);
+      if (d == 1 || d == -1) {
+        for (to = sq + d; to >= 0 && to < 64 && (to / 8) == rank; to += d) r |= 1ULL << to;
+      } else if (d == 8 || d == -8) {
+        for (to = sq + d; to >= 0 && to < 64 && (to % 8) == f; to += d) r |= 1ULL << to;
+      } else {
+        for (to = sq + d; to >= 0 && to < 64; to += d) {
+          int df = FILE(to) - f, dr = RANK(to) - rank;
+          if (df < -1 || df > 1 || dr < -1 || dr > 1) break;
+          r |= 1ULL << to;
+          f = FILE(to);
+          rank = RANK(to);
+        }
+      }
+      ray_att[sq][dir] = r;
+    }
+    for (to = 0; to < 64; to++) ray_dir[sq][to] = -1;
+    for (dir = 0; dir < 8; dir++) {
+      U64 r = ray_att[sq][dir];
+      while (r) { to = POP(r); r &= r - 1; ray_dir[sq][to] = dir; }
+    }
+  }
+  for (sq = 0; sq < 64; sq++) {
+    for (to = 0; to < 64; to++) {
+      dir = ray_dir[sq][to];
+      between_bb[sq][to] = 0;
+      line_bb[sq][to] = 0;
+      if (dir < 0) continue;
+      between_bb[sq][to] = ray_att[sq][dir] & ~ray_att[to][dir] & ~(1ULL << to);
+      line_bb[sq][to] = ray_att[sq][dir] | ray_att[sq][(dir + 4) & 7] | (1ULL << sq);
+    }
+  }
+}
+
+static U64 ray_slide(int sq, const int *dirs, U64 occ) {
+  U64 att = 0;
+  for (int i = 0; i < 4; i++) {
+    int d = dirs[i];
+    U64 r = ray_att[sq][d];
+    U64 blk = r & occ;
+    if (blk) r ^= ray_att[step[d] > 0 ? POP(blk) : bit_msb64(blk)][d];
+    att |= r;
+  }
+  return att;
+}
+
+static int bit_count(U64 x) {
+  int n = 0;
+  for (; x; x &= x - 1) n++;
+  return n;
+}
+
+/* Software PEXT: gathers the bits of x selected by mask into the low bits. */
+static U64 soft_pext(U64 x, U64 mask) {
+  U64 r = 0;
+  for (U64 bit = 1; mask; bit <<= 1) {
+    if (x & mask & (0 - mask)) r |= bit;
+    mask &= mask - 1;
+  }
+  return r;
+}
+
+static int init_magics(GenMagic *tab, int offset, const int *dirs, const U64 *nums) {
+  for (int sq = 0; sq < 64; sq++) {
+    GenMagic *m = &tab[sq];
+    U64 mask = 0;
+    for (int i = 0; i < 4; i++) {
+      int d = dirs[i];
+      U64 r = ray_att[sq][d];
+      if (r) mask |= r & ~(1ULL << (step[d] > 0 ? bit_msb64(r) : POP(r)));
+    }
+    int bits = bit_count(mask);
+    m->mask = mask;
+    m->magic = nums[sq];
+    m->shift = 64 - bits;
+    m->offset = offset;
+    U64 sub = 0;
+    do {
+      U64 att = ray_slide(sq, dirs, sub);
+      slider_att[offset + ((sub * m->magic) >> m->shift)] = att;
+      slider_att_pext[offset + soft_pext(sub, mask)] = att;
+      sub = (sub - mask) & mask;
+    } while (sub);
+    offset += 1 << bits;
+  }
+  return offset;
+}
+
+static void init_leapers(void) {
+  int sq, i;
+  for (sq = 0; sq < 64; sq++) {
+    U64 k = 0;
+    int f = FILE(sq), r = RANK(sq);
+    static const int dk[8][2] = {{0,-1},{1,-1},{1,0},{1,1},{0,1},{-1,1},{-1,0},{-1,-1}};
+    for (i = 0; i < 8; i++) {
+      int nf = f + dk[i][0], nr = r + dk[i][1];
+      if (nf >= 0 && nf < 8 && nr >= 0 && nr < 8) k |= 1ULL << SQ(nf, nr);
+    }
+    king_att[sq] = k;
+    k = 0;
+    static const int dn[8][2] = {{-2,-1},{-2,1},{-1,-2},{-1,2},{1,-2},{1,2},{2,-1},{2,1}};
+    for (i = 0; i < 8; i++) {
+      int nf = f + dn[i][0], nr = r + dn[i][1];
+      if (nf >= 0 && nf < 8 && nr >= 0 && nr < 8) k |= 1ULL << SQ(nf, nr);
+    }
+    knight_att[sq] = k;
+    pawn_push[W][sq] = (r < 7) ? (1ULL << (sq + 8)) : 0;
+    if (r == 1) pawn_push[W][sq] |= 1ULL << (sq + 16);
+    pawn_push[B][sq] = (r > 0) ? (1ULL << (sq - 8)) : 0;
+    if (r == 6) pawn_push[B][sq] |= 1ULL << (sq - 16);
+    pawn_att[W][sq] = 0;
+    if (r < 7) {
+      if (f > 0) pawn_att[W][sq] |= 1ULL << (sq + 7);
+      if (f < 7) pawn_att[W][sq] |= 1ULL << (sq + 9);
+    }
+    pawn_att[B][sq] = 0;
+    if (r > 0) {
+      if (f > 0) pawn_att[B][sq] |= 1ULL << (sq - 9);
+      if (f < 7) pawn_att[B][sq] |= 1ULL << (sq - 7);
+    }
+    inv_pawn_att[W][sq] = (r >= 1 && f <= 6 ? (1ULL << (sq - 7)) : 0) | (r >= 1 && f >= 1 ? (1ULL << (sq - 9)) : 0);
+    inv_pawn_att[B][sq] = (r <= 6 && f >= 1 ? (1ULL << (sq + 7)) : 0) | (r <= 6 && f <= 6 ? (1ULL << (sq + 9)) : 0);
+  }
+}
+
+/* Adjacent files of each file, and the squares in front of a pawn on its own
+   and adjacent files that an enemy pawn must not occupy for it to be passed. */
+static void init_pawn_masks(void) {
+  for (int f = 0; f < 8; f++)
+    isolated_mask[f] = (f > 0 ? 0x0101010101010101ULL << (f - 1) : 0) | (f < 7 ? 0x0101010101010101ULL << (f + 1) : 0);
+  for (int c = 0; c < 2; c++)
+    for (int sq = 0; sq < 64; sq++) {
+      U64 span = 0;
+      for (int r = RANK(sq) + (c == W ? 1 : -1); r >= 0 && r < 8; r += c == W ? 1 : -1)
+        span |= (0x0101010101010101ULL << FILE(sq)) & (0xFFULL << (8 * r));
+      passed_mask[c][sq] = span | ((span << 1) & 0xFEFEFEFEFEFEFEFEULL) | ((span >> 1) & 0x7F7F7F7F7F7F7F7FULL);
+    }
+}
+
+static void init_pst(void) {
+  for (int sq = 0; sq < 64; sq++) {
+    int r = RANK(sq), f = FILE(sq);
+    int cr = r < 4 ? r : 7 - r;
+    int cf = f < 4 ? f : 7 - f;
+    int c = cr + cf;
+    pst[W][P][sq] = (r >= 1 && r <= 5) ? (r - 1) * 8 + (f >= 2 && f <= 5 ? 10 : 0) : (r == 6 ? 50 : 0);
+    pst[W][N][sq] = c * 5 + (r >= 2 && r <= 5 && f >= 2 && f <= 5 ? 15 : 0);
+    pst[W][BISHOP][sq] = c * 4 + (f == r || f == 7 - r ? 12 : 0);
+    pst[W][R][sq] = (r == 6 ? 25 : 0) + (f == 0 || f == 7 ? -5 : 0) + (r == 7 ? 12 : 0);
+    pst[W][Q][sq] = c * 3 + (r >= 2 && r <= 5 ? 8 : 0);
+    pst[W][K][sq] = (r == 0 && f >= 2 && f <= 6 ? -30 : 0) + (r >= 1 ? (c * 4) : 0);
+  }
+  for (int p = 0; p < 6; p++)
+    for (int sq = 0; sq < 64; sq++) pst[B][p][sq] = pst[W][p][63 - sq];
+  for (int c = 0; c < 2; c++)
+    for (int p = 0; p < 6; p++)
+      for (int sq = 0; sq < 64; sq++) pst_score[c][p][sq] = S(pst[c][p][sq], pst[c][p][sq]);
+}
+
+static U64 rand64(void) {
+  static U64 s = 0x8a5cd789635d2dffULL;
+  s ^= s >> 12;
+  s ^= s << 25;
+  s ^= s >> 27;
+  return s * 2685821657736338717ULL;
+}
+
+static void init_zobrist(void) {
+  int c, p, sq;
+  for (c = 0; c < 2; c++)
+    for (p = 0; p < 6; p++)
+      for (sq = 0; sq < 64; sq++)
+        zobrist_piece[c][p][sq] = rand64();
+  zobrist_side = rand64();
+  for (sq = 0; sq < 8; sq++) zobrist_ep[sq] = rand64();
+  for (sq = 0; sq < 4; sq++) zobrist_castle[sq] = rand64();
+  for (c = 0; c < 16; c++) {
+    zobrist_castle_set[c] = 0;
+    for (p = 0; p < 4; p++)
+      if (c & (1 << p)) zobrist_castle_set[c] ^= zobrist_castle[p];
+  }
+}
+
+/* Cuckoo table of reversible non-pawn moves, keyed by the Zobrist difference
+   they make (side to move included), for upcoming-repetition detection. */
+static int init_cuckoo(void) {
+  int count = 0;
+  for (int c = 0; c < 2; c++)
+    for (int p = N; p <= K; p++)
+      for (int s1 = 0; s1 < 64; s1++)
+        for (int s2 = s1 + 1; s2 < 64; s2++) {
+          U64 att = p == N ? knight_att[s1] : p == K ? king_att[s1] : 0;
+          if (p == BISHOP || p == Q) att |= ray_slide(s1, bishop_dirs, 0);
+          if (p == R || p == Q) att |= ray_slide(s1, rook_dirs, 0);
+          if (!(att & (1ULL << s2))) continue;
+          U64 key = zobrist_piece[c][p][s1] ^ zobrist_piece[c][p][s2] ^ zobrist_side;
+          int move = MOVE(s1, s2, M_NORMAL);
+          int i = CUCKOO_H1(key);
+          for (;;) {
+            U64 tk = cuckoo_key[i];
+            int tm = cuckoo_move[i];
+            cuckoo_key[i] = key;
+            cuckoo_move[i] = move;
+            if (!tm) break;
+            key = tk;
+            move = tm;
+            i = (i == CUCKOO_H1(key)) ? CUCKOO_H2(key) : CUCKOO_H1(key);
+          }
+          count++;
+        }
+  return count;
+}
+
+/* Prints n values as one brace level per dimension; dims[] lists the extents. */
+static void emit_u64(const char *decl, const U64 *v, const int *dims, int ndims) {
+  int total = 1;
+  for (int i = 0; i < ndims; i++) total *= dims[i];
+  printf("%s = ", decl);
+  for (int i = 0; i < total; i++) {
+    int stride = 1;
+    for (int d = ndims - 1; d >= 0; d--) {
+      stride *= dims[d];
+      if (i % stride == 0) printf("{");
+    }
+    printf("0x%016llxULL", (unsigned long long)v[i]);
+    stride = 1;
+    for (int d = ndims - 1; d >= 0; d--) {
+      stride *= dims[d];
+      if ((i + 1) % stride == 0) printf("}");
+    }
+    if (i + 1 < total) printf((i + 1) % 4 ? ", " : ",\n");
+  }
+  printf(";\n\n");
+}
+
+static void emit_int(const char *decl, const int *v, const int *dims, int ndims) {
+  int total = 1;
+  for (int i = 0; i < ndims; i++) total *= dims[i];
+  printf("%s = ", decl);
+  for (int i = 0; i < total; i++) {
+    int stride = 1;
+    for (int d = ndims - 1; d >= 0; d--) {
+      stride *= dims[d];
+      if (i % stride == 0) printf("{");
+    }
+    printf("%d", v[i]);
+    stride = 1;
+    for (int d = ndims - 1; d >= 0; d--) {
+      stride *= dims[d];
+      if ((i + 1) % stride == 0) printf("}");
+    }
+    if (i + 1 < total) printf((i + 1) % 16 ? ", " : ",\n");
+  }
+  printf(";\n\n");
+}
+
+static void emit_magics(const char *name, const GenMagic *tab) {
+  printf("const Magic %s[64] = {\n", name);
+  for (int sq = 0; sq < 64; sq++)
+    printf("  {0x%016llxULL, 0x%016llxULL, %d, %d},\n", (unsigned long long)tab[sq].mask,
+           (unsigned long long)tab[sq].magic, tab[sq].offset, tab[sq].shift);
+  printf("};\n\n");
+}
+
+int main(void) {
+  init_rays();
+  init_leapers();
+  init_pst();
+  init_pawn_masks();
+  init_zobrist();
+  int n = init_magics(bishop_magic, 0, bishop_dirs, bishop_magic_num);
+  n = init_magics(rook_magic, n, rook_dirs, rook_magic_num);
+  if (init_cuckoo() != 3668) {
+    fprintf(stderr, "gen_tables: unexpected cuckoo entry count\n");
+    return 1;
+  }
+
+  printf("/* Generated by tools/gen_tables.c; do not edit. */\n#include \"tables.h\"\n\n");
+  emit_u64("const U64 knight_att[64]", knight_att, (const int[]){64}, 1);
+  emit_u64("const U64 king_att[64]", king_att, (const int[]){64}, 1);
+  emit_u64("const U64 pawn_push[2][64]", &pawn_push[0][0], (const int[]){2, 64}, 2);
+  emit_u64("const U64 pawn_att[2][64]", &pawn_att[0][0], (const int[]){2, 64}, 2);
+  emit_u64("const U64 inv_pawn_att[2][64]", &inv_pawn_att[0][0], (const int[]){2, 64}, 2);
+  emit_u64("const U64 ray_att[64][8]", &ray_att[0][0], (const int[]){64, 8}, 2);
+  emit_int("const int ray_dir[64][64]", &ray_dir[0][0], (const int[]){64, 64}, 2);
+  emit_u64("const U64 between_bb[64][64]", &between_bb[0][0], (const int[]){64, 64}, 2);
+  emit_u64("const U64 line_bb[64][64]", &line_bb[0][0], (const int[]){64, 64}, 2);
+  emit_u64("const U64 isolated_mask[8]", isolated_mask, (const int[]){8}, 1);
+  emit_u64("const U64 passed_mask[2][64]", &passed_mask[0][0], (const int[]){2, 64}, 2);
+  emit_int("const Score pst[2][6][64]", &pst_score[0][0][0], (const int[]){2, 6, 64}, 3);
+  emit_u64("const U64 zobrist_piece[2][6][64]", &zobrist_piece[0][0][0], (const int[]){2, 6, 64}, 3);
+  emit_u64("const U64 zobrist_side", &zobrist_side, (const int[]){1}, 0);
+  emit_u64("const U64 zobrist_ep[8]", zobrist_ep, (const int[]){8}, 1);
+  emit_u64("const U64 zobrist_castle[4]", zobrist_castle, (const int[]){4}, 1);
+  emit_u64("const U64 zobrist_castle_set[16]", zobrist_castle_set, (const int[]){16}, 1);
+  emit_magics("bishop_magic", bishop_magic);
+  emit_magics("rook_magic", rook_magic);
+  emit_u64("const U64 slider_att[SLIDER_TABLE_SIZE]", slider_att, (const int[]){n}, 1);
+  emit_u64("const U64 slider_att_pext[SLIDER_TABLE_SIZE]", slider_att_pext, (const int[]){n}, 1);
+  emit_u64("const U64 cuckoo_key[CUCKOO_SIZE]", cuckoo_key, (const int[]){CUCKOO_SIZE}, 1);
+  emit_int("const Move cuckoo_move[CUCKOO_SIZE]", cuckoo_move, (const int[]){CUCKOO_SIZE}, 1);
+  return 0;
+}
@@ -0,0 +1,402 @@
+/* Texel tuner for the eval PARAM_* weights (make tune). Reads "<fen> <result>"
+   lines, where the result is 1-0, 0-1, 1/2-1/2 or a white score in [0, 1],
+   resolves each position once with a material-only quiescence search, then
+   tunes in epochs: one eval_batch pass per weight linearises the eval around
+   the current weights, Adam runs full-batch gradient steps on that model, and
+   an exact pass accepts or rejects the rounded result. Writes a new params.h. */
+#include "board.h"
+#include "endgame.h"
+#include "eval.h"
+#include "movegen.h"
+#include "params.h"
+#include "tables.h"
+#include "types.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TUNE_MAX_THREADS 64
+#define TUNE_CHUNK 1024
+#define TUNE_TRUST 2
+#define TUNE_RELINEARIZE 4
+
+typedef struct {
+  const char *name;
+  int *v;
+} TuneParam;
+
+#define TP(name, v) { #name, &name },
+
+static TuneParam tune_params[] = {
+  TP(PARAM_VAL_KNIGHT, 0) TP(PARAM_VAL_BISHOP, 0) TP(PARAM_VAL_ROOK, 0) TP(PARAM_VAL_QUEEN, 0)
+  PARAM_LIST_EVAL(TP)
+};
+#define N_TUNE_PARAMS ((int)(sizeof(tune_params) / sizeof(tune_params[0])))
+
+static PackedBoard *data;
+static float *result;
+static int *score;
+static int n_data;
+static int tune_threads = 1;
+
+static long long wall_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int env_int(const char *name, int def) {
+  const char *env = getenv(name);
+  return (env && *env) ? atoi(env) : def;
+}
+
+/* Material + PST only: depends on nothing but the board, so threads can share it. */
+static int material_eval(const Board *b) {
+  int phase = b->phase > PARAM_PHASE_MAX ? PARAM_PHASE_MAX : b->phase < 0 ? 0 : b->phase;
+  int s = (MG_OF(b->psq) * phase + EG_OF(b->psq) * (PARAM_PHASE_MAX - phase)) / PARAM_PHASE_MAX;
+  return b->side == W ? s : -s;
+}
+
+/* Quiescence search that returns the quiet leaf of its principal variation. */
+static int resolve(const Board *b, int alpha, int beta, int qply, Board *leaf) {
+  int in_check = board_checkers(b) != 0;
+  int stand = material_eval(b);
+  *leaf = *b;
+  if (!in_check) {
+    if (stand >= beta) return stand;
+    if (stand > alpha) alpha = stand;
+  }
+  if (qply >= PARAM_QMAX) return stand;
+  MoveList ml;
+  gen_legal(b, &ml, in_check ? GEN_ALL : GEN_CAPTURES);
+  if (in_check && !ml.n) return -MATE + qply;
+  int best = in_check ? -INF : stand;
+  for (int i = 0; i < ml.n; i++) {
+    Move m = ml.m[i];
+    if (!in_check && !see_ge(b, m, 0)) continue;
+    Board child = *b, child_leaf;
+    Hist h;
+    if (!board_make(&child, m, &h)) continue;
+    int s = -resolve(&child, -beta, -alpha, qply + 1, &child_leaf);
+    if (s <= best) continue;
+    best = s;
+    if (s > alpha) {
+      alpha = s;
+      *leaf = child_leaf;
+    }
+    if (s >= beta) break;
+  }
+  return best;
+}
+
+typedef struct {
+  int next;
+} ResolveJob;
+
+static void *resolve_worker(void *arg) {
+  ResolveJob *job = arg;
+  Position *pos = aligned_alloc(_Alignof(Position), sizeof(Position));
+  if (!pos) return NULL;
+  for (;;) {
+    int start = __atomic_fetch_add(&job->next, TUNE_CHUNK, __ATOMIC_RELAXED);
+    if (start >= n_data) break;
+    int end = start + TUNE_CHUNK < n_data ? start + TUNE_CHUNK : n_data;
+    for (int i = start; i < end; i++) {
+      Board leaf;
+      board_unpack(&data[i], pos);
+      resolve(&pos->b, -INF, INF, 0, &leaf);
+      board_pack(&leaf, &data[i]);
+    }
+  }
+  free(pos);
+  return NULL;
+}
+
+static void resolve_all(int threads) {
+  ResolveJob job = { 0 };
+  pthread_t tid[TUNE_MAX_THREADS];
+  int started = 0;
+  for (int t = 1; t < threads; t++) {
+    if (pthread_create(&tid[started], NULL, resolve_worker, &job) == 0) started++;
+  }
+  resolve_worker(&job);
+  for (int t = 0; t < started; t++) pthread_join(tid[t], NULL);
+}
+
+static int parse_result(const char *line, float *r) {
+  if (strstr(line, "1/2-1/2")) { *r = 0.5f; return 1; }
+  if (strstr(line, "1-0")) { *r = 1.0f; return 1; }
+  if (strstr(line, "0-1")) { *r = 0.0f; return 1; }
+  const char *last = strrchr(line, ' ');
+  if (!last) return 0;
+  while (*last == ' ' || *last == '[' || *last == '"') last++;
+  char *end;
+  double v = strtod(last, &end);
+  if (end == last || v < 0 || v > 1) return 0;
+  *r = (float)v;
+  return 1;
+}
+
+static int load_data(const char *path) {
+  static Position pos;
+  FILE *f = fopen(path, "r");
+  if (!f) return 0;
+  int cap = 0;
+  char line[512];
+  while (fgets(line, sizeof line, f)) {
+    float r;
+    if (!strchr(line, '/') || !parse_result(line, &r)) continue;
+    if (n_data == cap) {
+      cap = cap ? cap * 2 : 1 << 16;
+      PackedBoard *d = realloc(data, (size_t)cap * sizeof(PackedBoard));
+      float *rs = realloc(result, (size_t)cap * sizeof(float));
+      if (d) data = d;
+      if (rs) result = rs;
+      if (!d || !rs) break;
+    }
+    board_from_fen(&pos, line);
+    if (!board_pack(&pos.b, &data[n_data])) continue;
+    result[n_data++] = r;
+  }
+  fclose(f);
+  score = malloc((size_t)(n_data ? n_data : 1) * sizeof(int));
+  return score != NULL && n_data > 0;
+}
+
+typedef struct {
+  void (*fn)(void *arg, int start, int end, int t);
+  void *arg;
+  int next, threads;
+} ParallelJob;
+
+static void *parallel_worker(void *p) {
+  ParallelJob *job = p;
+  int t = __atomic_fetch_add(&job->threads, 1, __ATOMIC_RELAXED);
+  for (;;) {
+    int start = __atomic_fetch_add(&job->next, TUNE_CHUNK, __ATOMIC_RELAXED);
+    if (start >= n_data) break;
+    job->fn(job->arg, start, start + TUNE_CHUNK < n_data ? start + TUNE_CHUNK : n_data, t);
+  }
+  return NULL;
+}
+
+/* Runs fn over [0, n_data) in TUNE_CHUNK slices; t is the worker's index for
+   per-thread partial sums. */
+static void parallel_for(void (*fn)(void *, int, int, int), void *arg) {
+  ParallelJob job = { fn, arg, 0, 0 };
+  pthread_t tid[TUNE_MAX_THREADS];
+  int started = 0;
+  for (int t = 1; t < tune_threads; t++)
+    if (pthread_create(&tid[started], NULL, parallel_worker, &job) == 0) started++;
+  parallel_worker(&job);
+  for (int t = 0; t < started; t++) pthread_join(tid[t], NULL);
+}
+
+static inline double sigmoid(double k, double s) {
+  return 1.0 / (1.0 + exp(-k * s * (M_LN10 / 400.0)));
+}
+
+/* Scores every position under the current weights into out, white's view.
+   Callers run init_tables() after changing a weight. */
+static void eval_pass(int *out) {
+  eval_batch(data, n_data, out);
+  for (int i = 0; i < n_data; i++)
+    if (data[i].side == B) out[i] = -out[i];
+}
+
+typedef struct {
+  double k;
+  double sum[TUNE_MAX_THREADS];
+} LossJob;
+
+static void loss_chunk(void *arg, int start, int end, int t) {
+  LossJob *job = arg;
+  double sum = 0;
+  for (int i = start; i < end; i++) {
+    double d = result[i] - sigmoid(job->k, score[i]);
+    sum += d * d;
+  }
+  job->sum[t] += sum;
+}
+
+static double loss(double k) {
+  LossJob job = { k, { 0 } };
+  parallel_for(loss_chunk, &job);
+  double sum = 0;
+  for (int t = 0; t < TUNE_MAX_THREADS; t++) sum += job.sum[t];
+  return sum / n_data;
+}
+
+/* Golden-section search for the sigmoid scale that best fits the current scores. */
+static double fit_k(void) {
+  const double g = 0.6180339887;
+  double a = 0.01, b = 3.0;
+  double c = b - g * (b - a), d = a + g * (b - a);
+  double fc = loss(c), fd = loss(d);
+  for (int i = 0; i < 40; i++) {
+    if (fc < fd) { b = d; d = c; fd = fc; c = b - g * (b - a); fc = loss(c); }
+    else { a = c; c = d; fc = fd; d = a + g * (b - a); fd = loss(d); }
+  }
+  return (a + b) / 2;
+}
+
+/* Linear model of the eval around the current weights: score[i] plus, for
+   each weight j, coef[i][j] per delta[j] it moves. The eval is close to
+   linear in its weights, so the coefficients are reused for a few epochs
+   while score[] follows the weights. Expects score[] to be current. */
+static int16_t *coef;
+static int *moved;
+static int delta[N_TUNE_PARAMS];
+
+static void linearize(void) {
+  for (int j = 0; j < N_TUNE_PARAMS; j++) {
+    int *v = tune_params[j].v, orig = *v;
+    delta[j] = abs(orig) / 8 > 1 ? abs(orig) / 8 : 1;
+    *v = orig + delta[j];
+    init_tables();
+    eval_pass(moved);
+    *v = orig;
+    for (int i = 0; i < n_data; i++) {
+      int d = moved[i] - score[i];
+      coef[(size_t)i * N_TUNE_PARAMS + j] = (int16_t)(d > INT16_MAX ? INT16_MAX : d < INT16_MIN ? INT16_MIN : d);
+    }
+  }
+  init_tables();
+}
+
+typedef struct {
+  double k;
+  double step[N_TUNE_PARAMS]; /* (x - x0) / delta per weight */
+  double loss[TUNE_MAX_THREADS];
+  double grad[TUNE_MAX_THREADS][N_TUNE_PARAMS];
+} GradJob;
+
+static void grad_chunk(void *arg, int start, int end, int t) {
+  GradJob *job = arg;
+  double sum = 0, *grad = job->grad[t];
+  for (int i = start; i < end; i++) {
+    const int16_t *c = coef + (size_t)i * N_TUNE_PARAMS;
+    double s = score[i];
+    for (int j = 0; j < N_TUNE_PARAMS; j++) s += c[j] * job->step[j];
+    double p = sigmoid(job->k, s), e = p - result[i];
+    sum += e * e;
+    double g = 2 * e * p * (1 - p) * job->k * (M_LN10 / 400.0);
+    for (int j = 0; j < N_TUNE_PARAMS; j++)
+      if (c[j]) grad[j] += g * c[j];
+  }
+  job->loss[t] += sum;
+}
+
+/* Adam on the linear model, starting from the current weights and kept
+   within TUNE_TRUST deltas of them, where the model holds; leaves the
+   rounded result in the weights and returns the model's loss. */
+static double descend(double k, int steps, double lr) {
+  static GradJob job;
+  double x0[N_TUNE_PARAMS], x[N_TUNE_PARAMS], m[N_TUNE_PARAMS] = { 0 }, v2[N_TUNE_PARAMS] = { 0 };
+  double model = 0;
+  for (int j = 0; j < N_TUNE_PARAMS; j++) x0[j] = x[j] = *tune_params[j].v;
+  for (int it = 1; it <= steps; it++) {
+    memset(&job, 0, sizeof job);
+    job.k = k;
+    for (int j = 0; j < N_TUNE_PARAMS; j++) job.step[j] = (x[j] - x0[j]) / delta[j];
+    parallel_for(grad_chunk, &job);
+    model = 0;
+    for (int t = 0; t < TUNE_MAX_THREADS; t++) model += job.loss[t];
+    model /= n_data;
+    for (int j = 0; j < N_TUNE_PARAMS; j++) {
+      double g = 0;
+      for (int t = 0; t < TUNE_MAX_THREADS; t++) g += job.grad[t][j];
+      g /= (double)n_data * delta[j];
+      m[j] = 0.9 * m[j] + 0.1 * g;
+      v2[j] = 0.999 * v2[j] + 0.001 * g * g;
+      double mh = m[j] / (1 - pow(0.9, it)), vh = v2[j] / (1 - pow(0.999, it));
+      x[j] -= lr * mh / (sqrt(vh) + 1e-12);
+      if (x[j] > x0[j] + TUNE_TRUST * delta[j]) x[j] = x0[j] + TUNE_TRUST * delta[j];
+      if (x[j] < x0[j] - TUNE_TRUST * delta[j]) x[j] = x0[j] - TUNE_TRUST * delta[j];
+    }
+  }
+  for (int j = 0; j < N_TUNE_PARAMS; j++) *tune_params[j].v = (int)lround(x[j]);
+  return model;
+}
+
+/* Copies params.h, substituting the tuned values into its X(name, value) lines. */
+static int write_params(const char *template_path, const char *out_path) {
+  FILE *in = fopen(template_path, "r");
+  if (!in) return 0;
+  FILE *out = fopen(out_path, "w");
+  if (!out) { fclose(in); return 0; }
+  char line[256], name[128];
+  while (fgets(line, sizeof line, in)) {
+    int i = N_TUNE_PARAMS;
+    if (sscanf(line, " X(%127[A-Z0-9_],", name) == 1)
+      for (i = 0; i < N_TUNE_PARAMS && strcmp(tune_params[i].name, name); i++) {}
+    if (i < N_TUNE_PARAMS) fprintf(out, "  X(%s, %d)%s", name, *tune_params[i].v, strchr(line, '\\') ? " \\\n" : "\n");
+    else fputs(line, out);
+  }
+  fclose(in);
+  return fclose(out) == 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: tune <labelled-fens> [out.h]\n");
+    return 1;
+  }
+  const char *out_path = argc > 2 ? argv[2] : "params_tuned.h";
+  tune_threads = env_int("EVAL_THREADS", 0);
+#if defined(_SC_NPROCESSORS_ONLN)
+  if (tune_threads < 1) tune_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if (tune_threads < 1) tune_threads = 1;
+  if (tune_threads > TUNE_MAX_THREADS) tune_threads = TUNE_MAX_THREADS;
+  int epochs = env_int("TUNE_EPOCHS", 10), steps = env_int("TUNE_STEPS", 100);
+  const char *env_lr = getenv("TUNE_LR");
+  double lr = env_lr && *env_lr ? atof(env_lr) : 1.0;
+  init_tables();
+  init_sliders(slider_pick(NULL));
+  endgame_init();
+  long long start = wall_ms();
+  if (!load_data(argv[1])) {
+    fprintf(stderr, "tune: no labelled positions in %s\n", argv[1]);
+    return 1;
+  }
+  coef = malloc((size_t)n_data * N_TUNE_PARAMS * sizeof(int16_t));
+  moved = malloc((size_t)n_data * sizeof(int));
+  if (!coef || !moved) {
+    fprintf(stderr, "tune: out of memory for %d positions\n", n_data);
+    return 1;
+  }
+  resolve_all(tune_threads);
+  fprintf(stderr, "tune: %d positions resolved in %lldms\n", n_data, wall_ms() - start);
+
+  eval_pass(score);
+  double k = fit_k();
+  double best = loss(k);
+  fprintf(stderr, "tune: k=%.4f loss=%.6f\n", k, best);
+  int saved[N_TUNE_PARAMS];
+  for (int epoch = 1; epoch <= epochs && lr >= 0.05; epoch++) {
+    for (int j = 0; j < N_TUNE_PARAMS; j++) saved[j] = *tune_params[j].v;
+    if ((epoch - 1) % TUNE_RELINEARIZE == 0) linearize();
+    double model = descend(k, steps, lr);
+    init_tables();
+    eval_pass(score);
+    double l = loss(k);
+    fprintf(stderr, "tune: epoch %d model=%.6f loss=%.6f lr=%.2f %lldms\n", epoch, model, l, lr, wall_ms() - start);
+    if (l < best) { best = l; continue; }
+    for (int j = 0; j < N_TUNE_PARAMS; j++) *tune_params[j].v = saved[j];
+    init_tables();
+    eval_pass(score);
+    lr /= 2;
+  }
+  if (!write_params("include/params.h", out_path)) {
+    fprintf(stderr, "tune: cannot write %s\n", out_path);
+    return 1;
+  }
+  fprintf(stderr, "tune: wrote %s\n", out_path);
+  return 0;
+}